@@ -0,0 +1,479 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+// Headless throughput benchmark. Runs every canned scene at several grid sizes and prints
+// one JSON document to stdout.
+//
+// Usage: sandstone_bench [--scene NAME] [--size WxH]... [--ticks N] [--warmup N]
+//                        [--threads N] [--seed N] [--scheme in_place|double_buffered]
+//                        [--dispatch bitboard|by_kind|virtual] [--heat-interval N]
+//                        [--replay JOURNAL] [--hash-log FILE] [--profile FILE]
+//                        [--check-dispatch] [--check-heat]
+//
+// --replay runs a recorded EditJournal instead of the canned scenes. --hash-log writes the
+// state hash after every measured tick, one "<tick> <hash>" line each, so two dispatches can
+// be diffed (schemes step differently by design and cannot). --profile turns the phase
+// profiler on and writes what it logged as CSV when FILE ends in .csv, as Chrome trace JSON
+// otherwise. --check-dispatch runs every scene with each dispatch on one thread instead of
+// timing it, and fails if a state hash ever differs from by_kind's. --check-heat fails if heat
+// conduction stops in a band before its temperatures have settled.
+
+#include "bench_scenes.h"
+#include "../core/cell_matrix.h"
+#include "../core/heat_diffusion.h"
+#include "../core/edit_journal.h"
+#include "../elements/element_registry.h"
+#include "../utils/profiler.h"
+#include "../utils/random_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+struct BenchOptions {
+    std::vector<std::string> scenes;
+    std::vector<Vector2I> sizes;
+    int ticks = 300;
+    int warmup = 20;
+    int threads = 1;
+    uint32_t seed = 1;
+    StepScheme scheme = StepScheme::IN_PLACE;
+    StepDispatch dispatch = StepDispatch::BITBOARD;
+    int heat_interval = 1;
+    std::string replay_path;
+    std::string hash_log_path;
+    std::string profile_path;
+    bool check_dispatch = false;
+    bool check_heat = false;
+};
+
+struct BenchResult {
+    std::string scene;
+    Vector2I size;
+    int ticks = 0;
+    double seconds = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    int awake_chunks = 0;
+    long peak_rss_kb = 0;
+};
+
+// Peak resident set size of the whole process so far, in KiB (-1 if unavailable)
+static long peak_rss_kb()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+static double percentile(std::vector<double> samples, const double p)
+{
+    if (samples.empty())
+        return 0.0;
+    const size_t k = std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(k), samples.end());
+    return samples[k];
+}
+
+static bool parse_size(const char *text, Vector2I &out)
+{
+    int w = 0, h = 0;
+    if (std::sscanf(text, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+        return false;
+    out = Vector2I(w, h);
+    return true;
+}
+
+static bool parse_args(const int argc, char **argv, BenchOptions &opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--check-dispatch") == 0) {
+            opts.check_dispatch = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--check-heat") == 0) {
+            opts.check_heat = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            std::fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (std::strcmp(arg, "--scene") == 0) {
+            if (find_bench_scene(value) == nullptr) {
+                std::fprintf(stderr, "unknown scene: %s\n", value);
+                return false;
+            }
+            opts.scenes.emplace_back(value);
+        } else if (std::strcmp(arg, "--size") == 0) {
+            Vector2I size;
+            if (!parse_size(value, size)) {
+                std::fprintf(stderr, "bad size: %s (expected WxH)\n", value);
+                return false;
+            }
+            opts.sizes.push_back(size);
+        } else if (std::strcmp(arg, "--ticks") == 0) {
+            opts.ticks = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--warmup") == 0) {
+            opts.warmup = std::max(0, std::atoi(value));
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            opts.threads = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            opts.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--scheme") == 0) {
+            if (std::strcmp(value, "in_place") == 0) {
+                opts.scheme = StepScheme::IN_PLACE;
+            } else if (std::strcmp(value, "double_buffered") == 0) {
+                opts.scheme = StepScheme::DOUBLE_BUFFERED;
+            } else {
+                std::fprintf(stderr, "unknown scheme: %s\n", value);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--dispatch") == 0) {
+            if (std::strcmp(value, "bitboard") == 0) {
+                opts.dispatch = StepDispatch::BITBOARD;
+            } else if (std::strcmp(value, "by_kind") == 0) {
+                opts.dispatch = StepDispatch::BY_KIND;
+            } else if (std::strcmp(value, "virtual") == 0) {
+                opts.dispatch = StepDispatch::VIRTUAL;
+            } else {
+                std::fprintf(stderr, "unknown dispatch: %s\n", value);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--heat-interval") == 0) {
+            opts.heat_interval = std::max(0, std::atoi(value));
+        } else if (std::strcmp(arg, "--replay") == 0) {
+            opts.replay_path = value;
+        } else if (std::strcmp(arg, "--hash-log") == 0) {
+            opts.hash_log_path = value;
+        } else if (std::strcmp(arg, "--profile") == 0) {
+            opts.profile_path = value;
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+        }
+        ++i;
+    }
+
+    if (opts.scenes.empty()) {
+        for (const auto &scene : get_bench_scenes()) {
+            opts.scenes.push_back(scene.name);
+        }
+    }
+    if (opts.sizes.empty()) {
+        opts.sizes = { Vector2I(256, 256), Vector2I(512, 512), Vector2I(1024, 1024) };
+    }
+    return true;
+}
+
+static void configure(Simulation &sim, const BenchOptions &opts)
+{
+    sim.set_thread_count(opts.threads);
+    sim.set_step_scheme(opts.scheme);
+    sim.set_step_dispatch(opts.dispatch);
+    sim.set_heat_interval(opts.heat_interval);
+}
+
+/**
+ * @brief Time `ticks` steps of an already populated simulation.
+ * @param before_tick Called before every step (warmup included) with the tick number.
+ * @param hash_log Receives one "<tick> <hash>" line per measured tick; may be null.
+ */
+static BenchResult run_ticks(Simulation &sim, const std::string &name,
+    const int warmup, const int ticks, const std::function<void(uint32_t)> &before_tick, FILE *hash_log)
+{
+    using Clock = std::chrono::steady_clock;
+
+    for (int i = 0; i < warmup; ++i) {
+        before_tick(sim.get_step_count());
+        sim.step();
+    }
+
+    std::vector<double> tick_ms;
+    tick_ms.reserve(ticks);
+    double seconds = 0.0;
+    for (int i = 0; i < ticks; ++i) {
+        before_tick(sim.get_step_count());
+        const auto t0 = Clock::now();
+        sim.step();
+        const auto t1 = Clock::now();
+        tick_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        seconds += std::chrono::duration<double>(t1 - t0).count();
+        if (hash_log) {
+            std::fprintf(hash_log, "%d %016llx\n", sim.get_step_count(),
+                static_cast<unsigned long long>(sim.get_state_hash()));
+        }
+    }
+
+    BenchResult result;
+    result.scene = name;
+    result.size = Vector2I(sim.get_width(), sim.get_height());
+    result.ticks = ticks;
+    result.seconds = seconds;
+    result.p50_ms = percentile(tick_ms, 0.50);
+    result.p99_ms = percentile(tick_ms, 0.99);
+    result.awake_chunks = sim.get_awake_chunk_count();
+    result.peak_rss_kb = peak_rss_kb();
+    return result;
+}
+
+static BenchResult run_scene(const SharedElementRegistry &registry, const BenchScene &scene,
+    const Vector2I &size, const BenchOptions &opts, FILE *hash_log)
+{
+    RandomUtils::reseed(opts.seed);
+    Simulation sim(size, registry);
+    configure(sim, opts);
+    sim.set_seed(opts.seed);
+    scene.setup(sim);
+
+    return run_ticks(sim, scene.name, opts.warmup, opts.ticks, [](uint32_t) {}, hash_log);
+}
+
+static bool run_replay(const SharedElementRegistry &registry, const BenchOptions &opts, FILE *hash_log,
+    std::vector<BenchResult> &results)
+{
+    EditJournal journal;
+    if (!journal.load(opts.replay_path)) {
+        std::fprintf(stderr, "could not read journal: %s\n", opts.replay_path.c_str());
+        return false;
+    }
+    for (const auto &id : journal.get_type_ids()) {
+        if (registry->get_type_by_id(id) == nullptr) {
+            std::fprintf(stderr, "journal uses unknown element: %s\n", id.c_str());
+            return false;
+        }
+    }
+
+    Simulation sim(journal.get_width(), journal.get_height(), registry);
+    configure(sim, opts);
+    sim.set_seed(journal.get_seed());
+
+    // Recorded sessions are replayed from tick 0, so no warmup
+    size_t cursor = 0;
+    results.push_back(run_ticks(sim, "replay", 0, static_cast<int>(journal.get_tick_count()),
+        [&](const uint32_t tick) { journal.apply_edits(sim, cursor, tick); }, hash_log));
+    return true;
+}
+
+/**
+ * @brief Step `scene` with every dispatch, in place on one thread with the same seed, and
+ *        compare the state hashes after every tick with those of BY_KIND, the reference.
+ * @return false, after reporting the first differing tick on stderr, if any diverges.
+ */
+static bool check_dispatch(const SharedElementRegistry &registry, const BenchScene &scene,
+    const Vector2I &size, const BenchOptions &opts)
+{
+    constexpr StepDispatch dispatches[3] = { StepDispatch::BY_KIND, StepDispatch::BITBOARD, StepDispatch::VIRTUAL };
+    constexpr const char *names[3] = { "by_kind", "bitboard", "virtual" };
+    std::vector<uint64_t> hashes[3];
+    for (int d = 0; d < 3; ++d) {
+        RandomUtils::reseed(opts.seed);
+        Simulation sim(size, registry);
+        sim.set_step_dispatch(dispatches[d]);
+        sim.set_heat_interval(opts.heat_interval);
+        sim.set_seed(opts.seed);
+        scene.setup(sim);
+        for (int i = 0; i < opts.warmup + opts.ticks; ++i) {
+            sim.step();
+            hashes[d].push_back(sim.get_state_hash());
+        }
+    }
+    bool ok = true;
+    for (int d = 1; d < 3; ++d) {
+        const auto diverged = std::ranges::mismatch(hashes[0], hashes[d]).in1;
+        if (diverged == hashes[0].end())
+            continue;
+        std::fprintf(stderr, "%s %dx%d: %s differs from by_kind after tick %d\n", scene.name.c_str(),
+            size.x, size.y, names[d], static_cast<int>(diverged - hashes[0].begin()) + 1);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Let a block of steam cool into the air below it with HeatDiffusion alone, and check
+ *        that no band stops conducting while two conducting neighbours in or next to it still
+ *        differ by more than HeatDiffusion::SETTLED_DELTA.
+ * @return false, after reporting the first frozen band on stderr, if one does.
+ */
+static bool check_heat(const SharedElementRegistry &registry)
+{
+    constexpr int WIDTH = 32;
+    constexpr int BANDS = 4;
+    constexpr int HEIGHT = BANDS * HeatDiffusion::BAND_ROWS;
+    constexpr int STEPS = 4000;
+    CellMatrix cells(WIDTH, HEIGHT, *registry);
+    const ElementIndex steam = registry->get_type_by_id("STEAM")->get_index();
+    // Only 1.5 degrees over the air: across a steam/air pair that moves less than SETTLED_DELTA
+    // per step, which must not pass for settled
+    for (int y = 0; y < HeatDiffusion::BAND_ROWS / 2; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            cells.set(x, y, { steam, 0, 0, 0, 26.5f });
+        }
+    }
+
+    HeatDiffusion heat;
+    std::vector<float> before(static_cast<size_t>(WIDTH) * HEIGHT);
+    std::vector<float> conductivity(before.size());
+    for (int step = 1; step <= STEPS; ++step) {
+        for (int y = 0; y < HEIGHT; ++y) {
+            for (int x = 0; x < WIDTH; ++x) {
+                before[y * WIDTH + x] = cells.get_temp(x, y);
+                conductivity[y * WIDTH + x] = registry->get_conductivity(cells.get_index(x, y));
+            }
+        }
+        heat.step(cells, nullptr);
+
+        bool band_changed[BANDS] = {};
+        for (int y = 0; y < HEIGHT; ++y) {
+            for (int x = 0; x < WIDTH; ++x) {
+                band_changed[y / HeatDiffusion::BAND_ROWS] |= cells.get_temp(x, y) != before[y * WIDTH + x];
+            }
+        }
+        // Every conducting pair, right and down, that was still apart before the step
+        for (int y = 0; y < HEIGHT; ++y) {
+            for (int x = 0; x < WIDTH; ++x) {
+                const int i = y * WIDTH + x;
+                for (const int j : { x + 1 < WIDTH ? i + 1 : -1, y + 1 < HEIGHT ? i + WIDTH : -1 }) {
+                    if (j < 0 || conductivity[i] <= 0.0f || conductivity[j] <= 0.0f)
+                        continue;
+                    if (std::fabs(before[i] - before[j]) <= HeatDiffusion::SETTLED_DELTA)
+                        continue;
+                    for (const int band : { i / WIDTH / HeatDiffusion::BAND_ROWS, j / WIDTH / HeatDiffusion::BAND_ROWS }) {
+                        if (band_changed[band])
+                            continue;
+                        std::fprintf(stderr, "heat: band %d froze at step %d with a %.4f degree step at (%d, %d)\n",
+                            band, step, std::fabs(before[i] - before[j]), x, y);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void print_json(const BenchOptions &opts, const std::vector<BenchResult> &results)
+{
+    std::printf("{\n");
+    std::printf("  \"threads\": %d,\n", opts.threads);
+    std::printf("  \"heat_interval\": %d,\n", opts.heat_interval);
+    std::printf("  \"warmup_ticks\": %d,\n", opts.warmup);
+    std::printf("  \"seed\": %u,\n", opts.seed);
+    std::printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        const double cells = static_cast<double>(r.size.x) * r.size.y;
+        const double ticks_per_sec = r.seconds > 0.0 ? r.ticks / r.seconds : 0.0;
+        std::printf("    {\"scene\": \"%s\", \"width\": %d, \"height\": %d, \"ticks\": %d, "
+                    "\"ticks_per_sec\": %.2f, \"cells_per_sec\": %.0f, "
+                    "\"p50_tick_ms\": %.4f, \"p99_tick_ms\": %.4f, "
+                    "\"awake_chunks\": %d, \"peak_rss_kb\": %ld}%s\n",
+            r.scene.c_str(), r.size.x, r.size.y, r.ticks,
+            ticks_per_sec, ticks_per_sec * cells,
+            r.p50_ms, r.p99_ms,
+            r.awake_chunks, r.peak_rss_kb,
+            i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ],\n");
+    std::printf("  \"peak_rss_kb\": %ld\n", peak_rss_kb());
+    std::printf("}\n");
+}
+
+int main(const int argc, char **argv)
+{
+    BenchOptions opts;
+    if (!parse_args(argc, argv, opts))
+        return 1;
+
+    std::string data_dir = "data";
+#ifdef SANDSTONE_DATA_DIR
+    data_dir = SANDSTONE_DATA_DIR;
+#endif
+    const SharedElementRegistry registry = ElementRegistry::load_shared(data_dir + "/elements");
+    if (registry->get_type_count() <= 1) {
+        std::fprintf(stderr, "no elements found in %s/elements\n", data_dir.c_str());
+        return 1;
+    }
+
+    if (opts.check_heat) {
+        const bool ok = check_heat(registry);
+        std::printf("{\n  \"heat_check\": \"%s\"\n}\n", ok ? "passed" : "failed");
+        return ok ? 0 : 1;
+    }
+
+    if (opts.check_dispatch) {
+        int failed = 0;
+        int checks = 0;
+        for (const auto &size : opts.sizes) {
+            for (const auto &name : opts.scenes) {
+                failed += check_dispatch(registry, *find_bench_scene(name), size, opts) ? 0 : 1;
+                ++checks;
+            }
+        }
+        std::printf("{\n  \"checks\": %d,\n  \"failed\": %d\n}\n", checks, failed);
+        return failed == 0 ? 0 : 1;
+    }
+
+    FILE *hash_log = nullptr;
+    if (!opts.hash_log_path.empty()) {
+        hash_log = std::fopen(opts.hash_log_path.c_str(), "w");
+        if (!hash_log) {
+            std::fprintf(stderr, "could not open hash log: %s\n", opts.hash_log_path.c_str());
+            return 1;
+        }
+    }
+
+    Profiler::set_enabled(!opts.profile_path.empty());
+
+    std::vector<BenchResult> results;
+    bool ok = true;
+    if (!opts.replay_path.empty()) {
+        ok = run_replay(registry, opts, hash_log, results);
+    } else {
+        for (const auto &size : opts.sizes) {
+            for (const auto &name : opts.scenes) {
+                results.push_back(run_scene(registry, *find_bench_scene(name), size, opts, hash_log));
+            }
+        }
+    }
+
+    if (hash_log)
+        std::fclose(hash_log);
+    if (!ok)
+        return 1;
+
+    if (!opts.profile_path.empty()) {
+        const std::string &path = opts.profile_path;
+        const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        if (!(csv ? Profiler::write_csv(path) : Profiler::write_chrome_trace(path))) {
+            std::fprintf(stderr, "could not write profile: %s\n", path.c_str());
+            return 1;
+        }
+    }
+
+    print_json(opts, results);
+    return 0;
+}
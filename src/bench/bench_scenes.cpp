@@ -0,0 +1,127 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "bench_scenes.h"
+
+#include "../utils/random_utils.h"
+
+#include <algorithm>
+#include <iterator>
+
+static void fill_rect(Simulation &sim, const std::string &id,
+    const int x0, const int y0, const int x1, const int y1)
+{
+    const ElementType *type = sim.get_type_by_id(id);
+    if (type == nullptr)
+        return;
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            sim.set_type_at(x, y, type, type->get_random_color_index());
+        }
+    }
+}
+
+static void add_floor(Simulation &sim)
+{
+    fill_rect(sim, "STONE", 0, sim.get_height() - 2, sim.get_width(), sim.get_height());
+}
+
+// A tall block of sand collapsing onto the floor
+static void setup_sand_avalanche(Simulation &sim)
+{
+    const int w = sim.get_width();
+    const int h = sim.get_height();
+    add_floor(sim);
+    fill_rect(sim, "SAND", w / 4, 0, w * 3 / 4, h / 2);
+}
+
+// A water column released into an empty basin
+static void setup_water_leveling(Simulation &sim)
+{
+    const int w = sim.get_width();
+    const int h = sim.get_height();
+    add_floor(sim);
+    fill_rect(sim, "WATER", 0, h / 4, w / 3, h - 2);
+}
+
+// Two gases side by side in a closed box
+static void setup_gas_mixing(Simulation &sim)
+{
+    const int w = sim.get_width();
+    const int h = sim.get_height();
+    add_floor(sim);
+    fill_rect(sim, "STONE", 0, 0, w, 2);
+    fill_rect(sim, "STEAM", 0, h / 3, w / 2, h - 2);
+    fill_rect(sim, "CHLORINE", w / 2, h / 3, w, h - 2);
+}
+
+// Sand columns standing on shelves of stone pegs two cells apart. Every grain that lands on a
+// peg competes with its neighbours for the same gaps, which exercises contested slides.
+static void setup_sand_pegs(Simulation &sim)
+{
+    const int w = sim.get_width();
+    const int h = sim.get_height();
+    const ElementType *stone = sim.get_type_by_id("STONE");
+    const ElementType *sand = sim.get_type_by_id("SAND");
+    if (stone == nullptr || sand == nullptr)
+        return;
+    add_floor(sim);
+    for (int shelf = h / 4; shelf < h - 2; shelf += h / 4) {
+        for (int x = 1; x < w; x += 2) {
+            sim.set_type_at(x, shelf, stone, stone->get_random_color_index());
+            for (int y = std::max(0, shelf - 12); y < shelf; ++y) {
+                sim.set_type_at(x, y, sand, sand->get_random_color_index());
+            }
+        }
+    }
+}
+
+// Solid terrain with a small sand spill; most chunks should fall asleep
+static void setup_static_world(Simulation &sim)
+{
+    const int w = sim.get_width();
+    const int h = sim.get_height();
+    fill_rect(sim, "STONE", 0, h / 2, w, h);
+    fill_rect(sim, "METAL", w / 8, h / 3, w / 4, h / 2);
+    fill_rect(sim, "SAND", w / 2, h / 2 - 8, w / 2 + 8, h / 2);
+}
+
+// Every cell holds a movable particle
+static void setup_saturated(Simulation &sim)
+{
+    const char *ids[] = { "SAND", "WATER", "STEAM", "GRAVEL", "SLUDGE", "CHLORINE" };
+    const ElementType *types[std::size(ids)];
+    for (size_t i = 0; i < std::size(ids); ++i) {
+        types[i] = sim.get_type_by_id(ids[i]);
+    }
+    for (int y = 0; y < sim.get_height(); ++y) {
+        for (int x = 0; x < sim.get_width(); ++x) {
+            const ElementType *type = types[RandomUtils::index(static_cast<int>(std::size(types)))];
+            if (type != nullptr)
+                sim.set_type_at(x, y, type, type->get_random_color_index());
+        }
+    }
+}
+
+const std::vector<BenchScene>& get_bench_scenes()
+{
+    static const std::vector<BenchScene> scenes = {
+        { "sand_avalanche", setup_sand_avalanche },
+        { "sand_pegs", setup_sand_pegs },
+        { "water_leveling", setup_water_leveling },
+        { "gas_mixing", setup_gas_mixing },
+        { "static_world", setup_static_world },
+        { "saturated", setup_saturated },
+    };
+    return scenes;
+}
+
+const BenchScene* find_bench_scene(const std::string &name)
+{
+    for (const auto &scene : get_bench_scenes()) {
+        if (scene.name == name)
+            return &scene;
+    }
+    return nullptr;
+}
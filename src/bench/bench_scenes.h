@@ -0,0 +1,28 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_BENCH_SCENES_H
+#define SANDSTONE_BENCH_SCENES_H
+
+#include "../core/simulation.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A canned world used by the headless tools.
+ *
+ * Scenes only describe the initial state and scale with the grid size, so the same scene
+ * can be run at any resolution.
+ */
+struct BenchScene {
+    std::string name;
+    std::function<void(Simulation &sim)> setup;
+};
+
+const std::vector<BenchScene>& get_bench_scenes();
+const BenchScene* find_bench_scene(const std::string &name);
+
+#endif //SANDSTONE_BENCH_SCENES_H
@@ -23,21 +23,15 @@ public:
     }
 
     virtual ~BaseRegistry() {
-        for (auto & type : types) {
-            delete type.second;
-        }
-    }
-
-    void reload() {
-        types.clear();
-        _load();
+        _free_types();
     }
 
     void initialize() {
         _load();
+        _on_loaded();
     }
 
-    T* get_type_by_id(const std::string &id) const {
+    const T* get_type_by_id(const std::string &id) const {
         auto it = types.find(id);
         if (it != types.end()) {
             return it->second;
@@ -54,6 +48,14 @@ public:
     }
 
 protected:
+    // Frees every loaded type first, so nothing may still point at them. Protected, as a
+    // registry shared between readers must be replaced rather than reloaded in place.
+    void reload() {
+        _free_types();
+        _load();
+        _on_loaded();
+    }
+
     void _load() {
         for (const auto & type : _load_specific()) {
             types[type->get_id()] = type;
@@ -62,6 +64,16 @@ protected:
 
     virtual std::vector<T*> _load_specific() = 0;
 
+    void _free_types() {
+        for (auto & type : types) {
+            delete type.second;
+        }
+        types.clear();
+    }
+
+    // Called after every (re)load, once `types` is populated
+    virtual void _on_loaded() {}
+
     L loader;
     std::unordered_map<std::string, T*> types;
 };
@@ -7,14 +7,14 @@
 
 #include <cstdint>
 
-class ElementType;
+#include "../elements/element_type.h"
 
 struct CellData {
-    const ElementType *type; // We can change this to point elsewhere, but not change the instance itself.
+    ElementIndex type = 0; // Index into the ElementRegistry tables, not an owned instance.
     uint8_t color_variant_index = 0;
     int8_t vel_x = 0; // -1 for left, 1 for right, 0 for none
     int8_t vel_y = 0; // -1 for up, 1 for down, 0 for none
-    int temp_c = 25;
+    float temp_c = 25.0f; // Fractional, so slow heat flows are not rounded away
 };
 
 #endif //CELL_DATA_H
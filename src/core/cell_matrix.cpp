@@ -6,31 +6,53 @@
 #include "../utils/element_type_checker.h"
 #include "../types/vector2i.h"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
 CellMatrix::CellMatrix(const int width, const int height, const ElementRegistry &element_registry)
-    : _width(width), _height(height)
+    : _registry(&element_registry), _width(width), _height(height), _chunks(width, height)
 {
-    _cells.resize(width * height,
-        CellData { element_registry.get_type_by_id("EMPTY"), 0 });
-    _written_gen.assign(width * height, 0);
+    _stride = width + 2 * PADDING;
+    const int total = _stride * (height + 2 * PADDING);
+    const CellData empty { ElementRegistry::EMPTY_INDEX, 0 };
+    _types.assign(total, empty.type);
+    _color_variants.assign(total, empty.color_variant_index);
+    _vel_x.assign(total, empty.vel_x);
+    _vel_y.assign(total, empty.vel_y);
+    _temps.assign(total, empty.temp_c);
+    _written_gen.assign(total, 0);
+
+    // Wall off everything outside the grid
+    const ElementIndex wall = element_registry.get_wall_index();
+    for (int y = -PADDING; y < height + PADDING; ++y) {
+        for (int x = -PADDING; x < width + PADDING; ++x) {
+            if (!within_bounds(x, y))
+                _types[flatten_coords(x, y)] = wall;
+        }
+    }
+    _words_per_row = (width + 63) / 64;
+    _occupied_bits.assign(static_cast<size_t>(_words_per_row) * height, 0);
+    _movable_bits.assign(static_cast<size_t>(_words_per_row) * height, 0);
 }
 
 int CellMatrix::flatten_coords(const int x, const int y) const
 {
-    return y * _width + x;
+    return (y + PADDING) * _stride + x + PADDING;
 }
 
 int CellMatrix::get_width() const { return _width; }
 int CellMatrix::get_height() const { return _height; }
 
-CellData& CellMatrix::get(const int x, const int y)
+CellData CellMatrix::get(const int x, const int y) const
 {
     const int idx = flatten_coords(x, y);
     return get(idx);
 }
 
-CellData & CellMatrix::get(const int idx)
+CellData CellMatrix::get(const int idx) const
 {
-    return _cells[idx];
+    return { _types[idx], _color_variants[idx], _vel_x[idx], _vel_y[idx], _temps[idx] };
 }
 
 const ElementType* CellMatrix::get_type(const int x, const int y) const
@@ -41,16 +63,46 @@ const ElementType* CellMatrix::get_type(const int x, const int y) const
 
 const ElementType* CellMatrix::get_type(const int idx) const
 {
-    return _cells[idx].type;
+    return _registry->get_type_by_index(_types[idx]);
+}
+
+ElementIndex CellMatrix::get_index(const int x, const int y) const
+{
+    return _types[flatten_coords(x, y)];
+}
+
+ElementIndex CellMatrix::get_index(const int idx) const
+{
+    return _types[idx];
+}
+
+ElementKind CellMatrix::get_kind(const int x, const int y) const
+{
+    return get_kind(flatten_coords(x, y));
+}
+
+ElementKind CellMatrix::get_kind(const int idx) const
+{
+    return _registry->get_kind(_types[idx]);
+}
+
+int CellMatrix::get_density(const int x, const int y) const
+{
+    return _registry->get_density(_types[flatten_coords(x, y)]);
+}
+
+bool CellMatrix::is_of_type(const int x, const int y, const ElementIndex index) const
+{
+    return get_index(x, y) == index;
 }
 
 bool CellMatrix::is_of_type(const int x, const int y,
     const std::string &type_id) const
 {
-    const auto type = get_type(x, y);
+    const ElementType *type = _registry->get_type_by_id(type_id);
     if (type == nullptr)
         return false;
-    return type->get_id() == type_id;
+    return is_of_type(x, y, type->get_index());
 }
 
 bool CellMatrix::is_of_type(const Vector2I &pos, const std::string &type_id) const
@@ -66,54 +118,129 @@ int CellMatrix::get_color_variation_index(const int x, const int y) const
 
 int CellMatrix::get_color_variation_index(const int idx) const
 {
-    return _cells[idx].color_variant_index;
+    return _color_variants[idx];
 }
 
-int CellMatrix::get_temp(const int x, const int y) const
+float CellMatrix::get_temp(const int x, const int y) const
 {
     const int idx = flatten_coords(x, y);
     return get_temp(idx);
 }
 
-int CellMatrix::get_temp(const int idx) const
+float CellMatrix::get_temp(const int idx) const
 {
-    return _cells[idx].temp_c;
+    return _temps[idx];
 }
 
 void CellMatrix::set(const int x, const int y, const CellData &cell_data)
 {
     const int idx = flatten_coords(x, y);
-    _cells[idx] = cell_data;
+    write(idx, x, y, cell_data);
+}
+
+void CellMatrix::set(const int idx, const CellData &cell_data)
+{
+    const int y = idx / _stride;
+    write(idx, idx - y * _stride - PADDING, y - PADDING, cell_data);
+}
+
+void CellMatrix::write(const int idx, const int x, const int y, const CellData &cell_data)
+{
+    _types[idx] = cell_data.type;
+    update_occupancy(x, y, cell_data.type);
+    _color_variants[idx] = cell_data.color_variant_index;
+    _vel_x[idx] = cell_data.vel_x;
+    _vel_y[idx] = cell_data.vel_y;
+    _temps[idx] = cell_data.temp_c;
 }
 
 void CellMatrix::set_type(const int x, const int y, const ElementType *type)
+{
+    set_index(x, y, type->get_index());
+}
+
+void CellMatrix::set_index(const int x, const int y, const ElementIndex index)
 {
     const int idx = flatten_coords(x, y);
-    _cells[idx].type = type;
+    _types[idx] = index;
+    update_occupancy(x, y, index);
+}
+
+static void set_bit(uint64_t &word, const uint64_t mask, const bool value)
+{
+    word = value ? word | mask : word & ~mask;
+}
+
+// Checkerboard chunks running in parallel can share a bitmap word at their borders, so bits
+// are flipped with an atomic RMW, and only when they actually change
+static void set_bit_atomic(uint64_t &word, const uint64_t mask, const bool value)
+{
+    std::atomic_ref<uint64_t> ref(word);
+    const bool current = (ref.load(std::memory_order_relaxed) & mask) != 0;
+    if (current == value)
+        return;
+    if (value) {
+        ref.fetch_or(mask, std::memory_order_relaxed);
+    } else {
+        ref.fetch_and(~mask, std::memory_order_relaxed);
+    }
+}
+
+void CellMatrix::update_occupancy(const int x, const int y, const ElementIndex type)
+{
+    const size_t word = static_cast<size_t>(y) * _words_per_row + x / 64;
+    const uint64_t mask = uint64_t { 1 } << (x % 64);
+    const bool occupied = type != ElementRegistry::EMPTY_INDEX;
+    const bool movable = _registry->is_movable(type);
+    if (_concurrent_writes) {
+        set_bit_atomic(_occupied_bits[word], mask, occupied);
+        set_bit_atomic(_movable_bits[word], mask, movable);
+    } else {
+        set_bit(_occupied_bits[word], mask, occupied);
+        set_bit(_movable_bits[word], mask, movable);
+    }
+}
+
+static uint64_t load_word(const std::vector<uint64_t> &bits, const size_t word)
+{
+    // atomic_ref needs a mutable object; the load itself does not write
+    return std::atomic_ref(const_cast<uint64_t&>(bits[word])).load(std::memory_order_relaxed);
+}
+
+uint64_t CellMatrix::get_occupied_word(const int y, const int word) const
+{
+    return load_word(_occupied_bits, static_cast<size_t>(y) * _words_per_row + word);
+}
+
+uint64_t CellMatrix::get_movable_word(const int y, const int word) const
+{
+    return load_word(_movable_bits, static_cast<size_t>(y) * _words_per_row + word);
 }
 
 void CellMatrix::set_color_variation_index(const int x, const int y, const uint8_t color_variant_index)
 {
     const int idx = flatten_coords(x, y);
-    _cells[idx].color_variant_index = color_variant_index;
+    _color_variants[idx] = color_variant_index;
+}
+
+void CellMatrix::set_temp(const int x, const int y, const float temp_c)
+{
+    _temps[flatten_coords(x, y)] = temp_c;
 }
 
 bool CellMatrix::is_empty(const int x, const int y) const
 {
-    const ElementType *dest_type = get_type(x, y);
-    return ElementTypeChecker::is_empty(*dest_type);
+    return ElementTypeChecker::is_empty(get_kind(x, y));
 }
 
 bool CellMatrix::is_of_kind(const int x, const int y, const ElementKind kind) const
 {
-    const ElementType *dest_type = get_type(x, y);
-    return ElementTypeChecker::is_of_kind(*dest_type, kind);
+    return ElementTypeChecker::is_of_kind(get_kind(x, y), kind);
 }
 
 bool CellMatrix::is_any_of_kinds(const int x, const int y, const std::initializer_list<ElementKind> kinds) const
 {
-    const ElementType *dest_type = get_type(x, y);
-    return ElementTypeChecker::is_any_of_kinds(*dest_type, kinds);
+    return ElementTypeChecker::is_any_of_kinds(get_kind(x, y), kinds);
 }
 
 bool CellMatrix::is_empty(const Vector2I &pos) const
@@ -131,6 +258,84 @@ bool CellMatrix::is_any_of_kinds(const Vector2I &pos, const std::initializer_lis
     return is_any_of_kinds(pos.x, pos.y, kinds);
 }
 
+const ElementIndex* CellMatrix::get_type_plane() const
+{
+    return _types.data();
+}
+
+const ElementRegistry& CellMatrix::get_registry() const
+{
+    return *_registry;
+}
+
+void CellMatrix::set_registry(const ElementRegistry &registry)
+{
+    _registry = &registry;
+}
+
+void CellMatrix::remap_rows(const std::vector<ElementIndex> &remap, const int row_begin, const int row_end)
+{
+    for (int y = row_begin; y < row_end; ++y) {
+        const int row = flatten_coords(-PADDING, y);
+        for (int i = row; i < row + _stride; ++i) {
+            const ElementIndex type = remap[_types[i]];
+            _types[i] = type;
+            // The new definition may have fewer colours
+            _color_variants[i] = static_cast<uint8_t>(std::min<int>(_color_variants[i], _registry->get_color_count(type) - 1));
+        }
+        if (y < 0 || y >= _height)
+            continue;
+        // Each row owns its bitmap words, so bands of rows never share one
+        for (int x = 0; x < _width; ++x) {
+            update_occupancy(x, y, _types[row + PADDING + x]);
+        }
+    }
+}
+
+const uint8_t* CellMatrix::get_color_variation_plane() const
+{
+    return _color_variants.data();
+}
+
+const float* CellMatrix::get_temp_plane() const
+{
+    return _temps.data();
+}
+
+void CellMatrix::swap_temp_plane(std::vector<float> &temps)
+{
+    _temps.swap(temps);
+}
+
+template <typename T>
+static uint64_t fnv1a(uint64_t hash, const T *values, const int count)
+{
+    const auto *bytes = reinterpret_cast<const unsigned char*>(values);
+    const size_t size = count * sizeof(T);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+uint64_t CellMatrix::get_state_hash() const
+{
+    // Plane by plane over the grid rows only; the wall border never changes
+    uint64_t hash = 0xCBF29CE484222325ull;
+    const auto hash_plane = [&](const auto &plane) {
+        for (int y = 0; y < _height; ++y) {
+            hash = fnv1a(hash, plane.data() + flatten_coords(0, y), _width);
+        }
+    };
+    hash_plane(_types);
+    hash_plane(_color_variants);
+    hash_plane(_vel_x);
+    hash_plane(_vel_y);
+    hash_plane(_temps);
+    return hash;
+}
+
 bool CellMatrix::within_bounds(const int x, const int y) const
 {
     return x >= 0 && x < _width && y >= 0 && y < _height;
@@ -151,6 +356,7 @@ void CellMatrix::begin_tick()
     } else {
         _gen = next;
     }
+    _chunks.begin_tick();
 }
 
 bool CellMatrix::is_written(const int x, const int y) const
@@ -164,3 +370,54 @@ void CellMatrix::mark_written(const int x, const int y)
     const int idx = flatten_coords(x, y);
     _written_gen[idx] = _gen;
 }
+
+uint64_t CellMatrix::get_written_mask(const int x, const int y, const int count) const
+{
+    const uint8_t *gens = _written_gen.data() + flatten_coords(x, y);
+    uint64_t mask = 0;
+    for (int i = 0; i < count; ++i) {
+        mask |= static_cast<uint64_t>(gens[i] == _gen) << i;
+    }
+    return mask;
+}
+
+void CellMatrix::wake(const int x, const int y)
+{
+    _chunks.wake(x, y);
+}
+
+void CellMatrix::wake_row(const int min_x, const int max_x, const int y)
+{
+    _chunks.wake_row(min_x, max_x, y);
+}
+
+void CellMatrix::move_down(const int x, const int y, const uint64_t cells, const int dx)
+{
+    for (uint64_t bits = cells; bits; bits &= bits - 1) {
+        const int sx = x + std::countr_zero(bits);
+        const int src = flatten_coords(sx, y);
+        const int dst = flatten_coords(sx + dx, y + 1);
+        const CellData target { _types[dst], 0, 0, 0, _temps[dst] };
+        write(dst, sx + dx, y + 1, get(src));
+        write(src, sx, y, target);
+        _written_gen[dst] = _gen;
+    }
+    // Sources and targets both get woken, a run of adjacent cells at a time
+    for (uint64_t bits = cells; bits; ) {
+        const int first = std::countr_zero(bits);
+        const int run = std::countr_one(bits >> first);
+        _chunks.wake_row(x + first, x + first + run - 1, y);
+        _chunks.wake_row(x + first + dx, x + first + run - 1 + dx, y + 1);
+        bits &= run + first >= 64 ? 0 : ~uint64_t { 0 } << (first + run);
+    }
+}
+
+void CellMatrix::wake_all()
+{
+    _chunks.wake_all();
+}
+
+const ChunkMap& CellMatrix::get_chunks() const
+{
+    return _chunks;
+}
@@ -6,18 +6,55 @@
 #define CELL_MATRIX_H
 
 #include "cell_data.h"
+#include "chunk_map.h"
 #include "../elements/element_registry.h"
 #include "../types/vector2i.h"
 
 #include <vector>
 
+/**
+ * @brief Grid of cells stored as a structure of arrays.
+ *
+ * Each CellData field lives in its own contiguous plane, so hot loops that only need the
+ * type (movement, density checks) or the temperature do not pull the rest of the cell through
+ * the cache. CellData is still used to move whole cells around by value.
+ *
+ * Cells store compact ElementIndex values; kind, density and ElementType lookups go through
+ * the registry's flat tables.
+ *
+ * Planes are padded with PADDING cells of wall sentinel on every side, so movement code can
+ * look up to PADDING cells past the edge without bounds checks: a wall is never empty and
+ * can never be displaced. Coordinates stay grid-relative; flatten_coords() accepts anything
+ * from -PADDING to size + PADDING - 1.
+ *
+ * Two occupancy bitmaps (one bit per cell, rows padded to whole 64-bit words) track which
+ * cells are non-empty and which are movable, so scans can jump straight to the cells that
+ * need work. Every type write keeps them current.
+ */
 class CellMatrix {
+public:
+    // Must cover the farthest cell any movement routine inspects
+    static constexpr int PADDING = ChunkMap::WAKE_MARGIN;
+
 private:
-    std::vector<CellData> _cells;
+    const ElementRegistry *_registry = nullptr;
+    std::vector<ElementIndex> _types;
+    std::vector<uint8_t> _color_variants;
+    std::vector<int8_t> _vel_x;
+    std::vector<int8_t> _vel_y;
+    std::vector<float> _temps;
     int _width, _height;
+    int _stride = 0; // Padded row length
+    // Occupancy bitmaps, _words_per_row words per row
+    int _words_per_row = 0;
+    std::vector<uint64_t> _occupied_bits;
+    std::vector<uint64_t> _movable_bits;
+    bool _concurrent_writes = false;
     // Generation-stamped write mask
     std::vector<uint8_t> _written_gen;
     uint8_t _gen = 1;
+    // Sleeping/dirty-region tracking; rects promoted in begin_tick()
+    ChunkMap _chunks;
 public:
     CellMatrix() : _width(0), _height(0) {}
     CellMatrix(int width, int height, const ElementRegistry &element_registry);
@@ -26,19 +63,28 @@ public:
 
     int get_width() const;
     int get_height() const;
-    CellData& get(int x, int y);
-    CellData& get(int idx);
+    CellData get(int x, int y) const;
+    CellData get(int idx) const;
     const ElementType* get_type(int x, int y) const;
     const ElementType* get_type(int idx) const;
+    ElementIndex get_index(int x, int y) const;
+    ElementIndex get_index(int idx) const;
+    ElementKind get_kind(int x, int y) const;
+    ElementKind get_kind(int idx) const;
+    int get_density(int x, int y) const;
+    bool is_of_type(int x, int y, ElementIndex index) const;
     bool is_of_type(int x, int y, const std::string &type_id) const;
     bool is_of_type(const Vector2I &pos, const std::string &type_id) const;
     int get_color_variation_index(int x, int y) const;
     int get_color_variation_index(int idx) const;
-    int get_temp(int x, int y) const;
-    int get_temp(int idx) const;
+    float get_temp(int x, int y) const;
+    float get_temp(int idx) const;
     void set(int x, int y, const CellData &cell_data);
+    void set(int idx, const CellData &cell_data);
     void set_type(int x, int y, const ElementType *type);
+    void set_index(int x, int y, ElementIndex index);
     void set_color_variation_index(int x, int y, uint8_t color_variant_index);
+    void set_temp(int x, int y, float temp_c);
 
     bool is_empty(int x, int y) const;
     bool is_of_kind(int x, int y, ElementKind kind) const;
@@ -49,6 +95,34 @@ public:
     bool is_any_of_kinds(const Vector2I &pos, std::initializer_list<ElementKind> kinds) const;
 
 
+    // Raw planes, indexed by flatten_coords(); rows are get_stride() apart
+    int get_stride() const { return _stride; }
+    const ElementIndex* get_type_plane() const;
+    const ElementRegistry& get_registry() const;
+
+    /**
+     * @brief Move the matrix over to another registry (see Simulation::set_registry).
+     * @details After set_registry(), every padded row in [-PADDING, height + PADDING) has to go
+     *          through remap_rows() once; `remap` maps old indices to new ones. Disjoint row
+     *          ranges may be remapped concurrently.
+     */
+    void set_registry(const ElementRegistry &registry);
+    void remap_rows(const std::vector<ElementIndex> &remap, int row_begin, int row_end);
+    const uint8_t* get_color_variation_plane() const;
+    const float* get_temp_plane() const;
+    // Exchange the whole temperature plane (used by HeatDiffusion to publish its result)
+    void swap_temp_plane(std::vector<float> &temps);
+
+    // FNV-1a over every cell plane (types, colours, velocities, temperatures)
+    uint64_t get_state_hash() const;
+
+    // Occupancy bitmap words; bit (x % 64) of word (x / 64) in row y is cell (x, y)
+    int get_words_per_row() const { return _words_per_row; }
+    uint64_t get_occupied_word(int y, int word) const;
+    uint64_t get_movable_word(int y, int word) const;
+    // Must be on while several threads write at once; bitmap updates then use atomic RMW
+    void set_concurrent_writes(bool concurrent) { _concurrent_writes = concurrent; }
+
     bool within_bounds(int x, int y) const;
     bool within_bounds(const Vector2I& pos) const;
 
@@ -56,6 +130,25 @@ public:
     void begin_tick();
     bool is_written(int x, int y) const;
     void mark_written(int x, int y);
+    // Bit i set if cell (x + i, y) was written this tick; `count` is at most 64, padding allowed
+    uint64_t get_written_mask(int x, int y, int count) const;
+
+    /**
+     * @brief Move each cell (x + i, y) with bit i of `cells` set to (x + i + dx, y + 1).
+     * @details Does what MovementUtils::move_cell does for each of them, waking one run of
+     *          adjacent cells at a time. Every target must be empty and not yet written.
+     */
+    void move_down(int x, int y, uint64_t cells, int dx);
+
+    // Chunk API: wake the neighbourhood of a changed cell for the next tick
+    void wake(int x, int y);
+    void wake_row(int min_x, int max_x, int y);
+    void wake_all();
+    const ChunkMap& get_chunks() const;
+
+private:
+    void write(int idx, int x, int y, const CellData &cell_data);
+    void update_occupancy(int x, int y, ElementIndex type);
 };
 
 
@@ -0,0 +1,140 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "chunk_map.h"
+
+static void atomic_min(std::atomic<int> &target, const int value)
+{
+    int current = target.load(std::memory_order_relaxed);
+    while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+static void atomic_max(std::atomic<int> &target, const int value)
+{
+    int current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+ChunkMap::Chunk::Chunk(const Chunk &other)
+    : current(other.current), idle_ticks(other.idle_ticks)
+{
+    store_next(other.load_next());
+}
+
+ChunkMap::Chunk& ChunkMap::Chunk::operator=(const Chunk &other)
+{
+    current = other.current;
+    idle_ticks = other.idle_ticks;
+    store_next(other.load_next());
+    return *this;
+}
+
+Rect2I ChunkMap::Chunk::load_next() const
+{
+    return {
+        next_min_x.load(std::memory_order_relaxed),
+        next_min_y.load(std::memory_order_relaxed),
+        next_max_x.load(std::memory_order_relaxed),
+        next_max_y.load(std::memory_order_relaxed)
+    };
+}
+
+void ChunkMap::Chunk::store_next(const Rect2I &rect)
+{
+    next_min_x.store(rect.min_x, std::memory_order_relaxed);
+    next_min_y.store(rect.min_y, std::memory_order_relaxed);
+    next_max_x.store(rect.max_x, std::memory_order_relaxed);
+    next_max_y.store(rect.max_y, std::memory_order_relaxed);
+}
+
+void ChunkMap::Chunk::include_next(const Rect2I &rect)
+{
+    atomic_min(next_min_x, rect.min_x);
+    atomic_min(next_min_y, rect.min_y);
+    atomic_max(next_max_x, rect.max_x);
+    atomic_max(next_max_y, rect.max_y);
+}
+
+ChunkMap::ChunkMap(const int width, const int height)
+    : _bounds(0, 0, width - 1, height - 1),
+      _chunks_x((width + CHUNK_SIZE - 1) / CHUNK_SIZE),
+      _chunks_y((height + CHUNK_SIZE - 1) / CHUNK_SIZE)
+{
+    _chunks.resize(_chunks_x * _chunks_y);
+    wake_all();
+}
+
+void ChunkMap::wake(const int x, const int y)
+{
+    wake_row(x, x, y);
+}
+
+void ChunkMap::wake_row(const int min_x, const int max_x, const int y)
+{
+    // The cells' areas overlap into one rect, so each chunk gets the same rect either way
+    const Rect2I area = Rect2I(
+        min_x - WAKE_MARGIN, y - WAKE_MARGIN,
+        max_x + WAKE_MARGIN, y + WAKE_MARGIN).intersected(_bounds);
+    if (area.is_empty())
+        return;
+
+    for (int cy = area.min_y / CHUNK_SIZE; cy <= area.max_y / CHUNK_SIZE; ++cy) {
+        for (int cx = area.min_x / CHUNK_SIZE; cx <= area.max_x / CHUNK_SIZE; ++cx) {
+            const Rect2I chunk_bounds(
+                cx * CHUNK_SIZE, cy * CHUNK_SIZE,
+                cx * CHUNK_SIZE + CHUNK_SIZE - 1, cy * CHUNK_SIZE + CHUNK_SIZE - 1);
+            _chunks[cy * _chunks_x + cx].include_next(area.intersected(chunk_bounds));
+        }
+    }
+}
+
+void ChunkMap::wake_all()
+{
+    for (int cy = 0; cy < _chunks_y; ++cy) {
+        for (int cx = 0; cx < _chunks_x; ++cx) {
+            const Rect2I chunk_bounds(
+                cx * CHUNK_SIZE, cy * CHUNK_SIZE,
+                cx * CHUNK_SIZE + CHUNK_SIZE - 1, cy * CHUNK_SIZE + CHUNK_SIZE - 1);
+            _chunks[cy * _chunks_x + cx].store_next(chunk_bounds.intersected(_bounds));
+        }
+    }
+}
+
+void ChunkMap::begin_tick()
+{
+    for (Chunk &chunk : _chunks) {
+        if (const Rect2I next = chunk.load_next(); !next.is_empty()) {
+            chunk.current = next;
+            chunk.idle_ticks = 0;
+        } else if (!chunk.current.is_empty() && ++chunk.idle_ticks >= SLEEP_DELAY) {
+            chunk.current.clear();
+        }
+        chunk.store_next(Rect2I());
+    }
+}
+
+bool ChunkMap::is_awake(const int cx, const int cy) const
+{
+    return !_chunks[cy * _chunks_x + cx].current.is_empty();
+}
+
+const Rect2I& ChunkMap::get_dirty_rect(const int cx, const int cy) const
+{
+    return _chunks[cy * _chunks_x + cx].current;
+}
+
+Rect2I ChunkMap::get_pending_rect(const int cx, const int cy) const
+{
+    return _chunks[cy * _chunks_x + cx].load_next();
+}
+
+int ChunkMap::count_awake() const
+{
+    int awake = 0;
+    for (const Chunk &chunk : _chunks) {
+        if (!chunk.current.is_empty())
+            ++awake;
+    }
+    return awake;
+}
@@ -0,0 +1,86 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_CHUNK_MAP_H
+#define SANDSTONE_CHUNK_MAP_H
+
+#include "../types/rect2i.h"
+
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Splits the grid into fixed-size chunks that sleep until something near them changes.
+ *
+ * Every chunk keeps two dirty rects: the one being scanned this tick and the one collecting
+ * wakes for the next tick. begin_tick() promotes the latter. A chunk with no new wakes keeps
+ * its last rect for SLEEP_DELAY ticks before going to sleep, so cells whose moves are gated
+ * by randomness still get a few more chances.
+ *
+ * wake() is safe to call from several threads at once (the pending rects are atomic), which
+ * the checkerboard stepping relies on when two chunks of the same phase wake a shared neighbour.
+ */
+class ChunkMap {
+public:
+    static constexpr int CHUNK_SIZE = 32;
+    // Must cover the farthest cell any movement routine inspects (gas dispersion is 4).
+    static constexpr int WAKE_MARGIN = 4;
+    static constexpr int SLEEP_DELAY = 8;
+
+    // Same-phase chunks in checkerboard stepping are one chunk apart; what they read and write
+    // (reach plus wake margin on either side) must never overlap.
+    static_assert(CHUNK_SIZE > 4 * WAKE_MARGIN);
+
+    ChunkMap() = default;
+    ChunkMap(int width, int height);
+
+    int get_chunks_x() const { return _chunks_x; }
+    int get_chunks_y() const { return _chunks_y; }
+
+    /**
+     * @brief Mark the neighbourhood of (x, y) dirty for the next tick.
+     *
+     * Wakes neighbouring chunks too when the margin crosses a chunk border.
+     */
+    void wake(int x, int y);
+    // Same as wake() on every cell of row y from min_x to max_x
+    void wake_row(int min_x, int max_x, int y);
+    void wake_all();
+
+    /**
+     * @brief Promote the pending dirty rects to the ones scanned this tick.
+     */
+    void begin_tick();
+
+    bool is_awake(int cx, int cy) const;
+    const Rect2I& get_dirty_rect(int cx, int cy) const;
+    // Wakes collected since the last begin_tick(), i.e. the area changed since then
+    Rect2I get_pending_rect(int cx, int cy) const;
+    int count_awake() const;
+
+private:
+    struct Chunk {
+        Rect2I current;
+        std::atomic<int> next_min_x { INT_MAX };
+        std::atomic<int> next_min_y { INT_MAX };
+        std::atomic<int> next_max_x { INT_MIN };
+        std::atomic<int> next_max_y { INT_MIN };
+        int idle_ticks = 0;
+
+        Chunk() = default;
+        Chunk(const Chunk &other);
+        Chunk& operator=(const Chunk &other);
+
+        Rect2I load_next() const;
+        void store_next(const Rect2I &rect);
+        void include_next(const Rect2I &rect);
+    };
+
+    std::vector<Chunk> _chunks;
+    Rect2I _bounds;
+    int _chunks_x = 0;
+    int _chunks_y = 0;
+};
+
+#endif //SANDSTONE_CHUNK_MAP_H
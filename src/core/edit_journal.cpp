@@ -0,0 +1,153 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "edit_journal.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <fstream>
+#include <type_traits>
+
+static constexpr char JOURNAL_MAGIC[4] = { 'S', 'S', 'J', 'R' };
+static constexpr uint32_t JOURNAL_VERSION = 1;
+// Larger grids are taken for corruption rather than allocated
+static constexpr int32_t MAX_JOURNAL_SIDE = 1 << 14;
+
+// Fixed-width little-endian fields, so journals move between machines
+template <typename T>
+static void write_le(std::ostream &out, const T value)
+{
+    auto v = static_cast<std::make_unsigned_t<T>>(value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out.put(static_cast<char>(v & 0xFF));
+        v = static_cast<decltype(v)>(v >> 8);
+    }
+}
+
+template <typename T>
+static bool read_le(std::istream &in, T &value)
+{
+    std::make_unsigned_t<T> v = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        const int c = in.get();
+        if (c == EOF)
+            return false;
+        v |= static_cast<decltype(v)>(static_cast<decltype(v)>(c) << (8 * i));
+    }
+    value = static_cast<T>(v);
+    return true;
+}
+
+void EditJournal::begin(const int width, const int height, const uint32_t seed, const ElementRegistry &registry)
+{
+    _width = width;
+    _height = height;
+    _seed = seed;
+    _tick_count = 0;
+    _edits.clear();
+    _type_ids.clear();
+    for (const ElementType *type : registry.get_types_by_index()) {
+        _type_ids.push_back(type->get_id());
+    }
+}
+
+void EditJournal::record(const uint32_t tick, const int x, const int y, const ElementIndex type, const int color)
+{
+    _edits.push_back({ tick, x, y, type, static_cast<int16_t>(color) });
+    if (tick > _tick_count)
+        _tick_count = tick;
+}
+
+bool EditJournal::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+
+    out.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    write_le<uint32_t>(out, JOURNAL_VERSION);
+    write_le<int32_t>(out, _width);
+    write_le<int32_t>(out, _height);
+    write_le<uint32_t>(out, _seed);
+    write_le<uint32_t>(out, _tick_count);
+
+    write_le<uint16_t>(out, static_cast<uint16_t>(_type_ids.size()));
+    for (const auto &id : _type_ids) {
+        write_le<uint16_t>(out, static_cast<uint16_t>(id.size()));
+        out.write(id.data(), static_cast<std::streamsize>(id.size()));
+    }
+
+    write_le<uint64_t>(out, _edits.size());
+    for (const Edit &e : _edits) {
+        write_le<uint32_t>(out, e.tick);
+        write_le<int32_t>(out, e.x);
+        write_le<int32_t>(out, e.y);
+        write_le<uint16_t>(out, e.type);
+        write_le<int16_t>(out, e.color);
+    }
+    return static_cast<bool>(out);
+}
+
+bool EditJournal::load(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, JOURNAL_MAGIC))
+        return false;
+    if (!read_le(in, version) || version != JOURNAL_VERSION)
+        return false;
+
+    EditJournal j;
+    if (!read_le(in, j._width) || !read_le(in, j._height)
+        || !read_le(in, j._seed) || !read_le(in, j._tick_count))
+        return false;
+    if (j._width <= 0 || j._height <= 0 || j._width > MAX_JOURNAL_SIDE || j._height > MAX_JOURNAL_SIDE)
+        return false;
+
+    uint16_t id_count = 0;
+    if (!read_le(in, id_count))
+        return false;
+    for (uint16_t i = 0; i < id_count; ++i) {
+        uint16_t len = 0;
+        if (!read_le(in, len))
+            return false;
+        std::string id(len, '\0');
+        if (!in.read(id.data(), len))
+            return false;
+        j._type_ids.push_back(std::move(id));
+    }
+
+    uint64_t edit_count = 0;
+    if (!read_le(in, edit_count))
+        return false;
+    for (uint64_t i = 0; i < edit_count; ++i) {
+        Edit e {};
+        if (!read_le(in, e.tick) || !read_le(in, e.x) || !read_le(in, e.y)
+            || !read_le(in, e.type) || !read_le(in, e.color))
+            return false;
+        if (e.type >= j._type_ids.size())
+            return false;
+        // Only edits that landed are recorded, in tick order; apply_edits() relies on the order
+        if (e.x < 0 || e.y < 0 || e.x >= j._width || e.y >= j._height)
+            return false;
+        if (!j._edits.empty() && e.tick < j._edits.back().tick)
+            return false;
+        j._edits.push_back(e);
+    }
+
+    *this = std::move(j);
+    return true;
+}
+
+void EditJournal::apply_edits(Simulation &sim, size_t &cursor, const uint32_t tick) const
+{
+    while (cursor < _edits.size() && _edits[cursor].tick == tick) {
+        const Edit &e = _edits[cursor++];
+        sim.set_type_at(e.x, e.y, _type_ids[e.type], e.color);
+    }
+}
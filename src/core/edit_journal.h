@@ -0,0 +1,70 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_EDIT_JOURNAL_H
+#define SANDSTONE_EDIT_JOURNAL_H
+
+#include "../elements/element_registry.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Simulation;
+
+/**
+ * @brief Compact binary log of every cell edit, used to replay a session headlessly.
+ *
+ * Edits are stamped with the tick they happened before. Element types are stored as indices
+ * into the journal's own id table, so a journal survives the registry renumbering elements.
+ * Replays are bit-exact as long as the simulation is seeded with get_seed() and stepped on
+ * a single thread.
+ */
+class EditJournal {
+public:
+    struct Edit {
+        uint32_t tick;
+        int32_t x;
+        int32_t y;
+        uint16_t type; // Index into get_type_ids()
+        int16_t color; // -1 keeps the cell's colour variant
+    };
+
+    void begin(int width, int height, uint32_t seed, const ElementRegistry &registry);
+    void record(uint32_t tick, int x, int y, ElementIndex type, int color);
+    void set_tick_count(uint32_t ticks) { _tick_count = ticks; }
+
+    bool save(const std::string &path) const;
+    /**
+     * @brief Replace this journal with the one saved at `path`.
+     * @return false, leaving this journal untouched, if the file is unreadable or malformed:
+     *         a grid side outside [1, 16384], edits outside the grid or out of tick order.
+     */
+    bool load(const std::string &path);
+
+    int get_width() const { return _width; }
+    int get_height() const { return _height; }
+    uint32_t get_seed() const { return _seed; }
+    uint32_t get_tick_count() const { return _tick_count; }
+    const std::vector<std::string>& get_type_ids() const { return _type_ids; }
+    const std::vector<Edit>& get_edits() const { return _edits; }
+
+    /**
+     * @brief Apply every edit stamped with `tick`, starting from `cursor`.
+     * @param sim Simulation to edit; must be built from a registry holding the journal's ids.
+     * @param cursor Position in get_edits(); advanced past the applied edits.
+     * @param tick Tick whose edits are applied.
+     */
+    void apply_edits(Simulation &sim, size_t &cursor, uint32_t tick) const;
+
+private:
+    int _width = 0;
+    int _height = 0;
+    uint32_t _seed = 0;
+    uint32_t _tick_count = 0;
+    std::vector<std::string> _type_ids; // Registry ids at record time, by ElementIndex
+    std::vector<Edit> _edits;
+};
+
+#endif //SANDSTONE_EDIT_JOURNAL_H
@@ -0,0 +1,116 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "granular_engine.h"
+#include "cell_matrix.h"
+#include "../utils/random_utils.h"
+
+#include <bit>
+
+bool GranularEngine::step_span(CellMatrix &cells, const int y, const int min_x, const int max_x,
+    const bool scan_left_to_right, Report &report)
+{
+    const int span_width = max_x - min_x + 1;
+    if (span_width <= 0 || span_width > MAX_SPAN)
+        return false;
+
+    // Bit i of every mask is cell (origin + i); the span is bits 1 to n - 2
+    const int origin = min_x - 1;
+    const int n = span_width + 2;
+    const ElementRegistry &registry = cells.get_registry();
+    const ElementIndex *types = cells.get_type_plane();
+
+    // Row y: empty cells, and the grains to step, which must all be one MovableSolid
+    const ElementIndex *row = types + cells.flatten_coords(origin, y);
+    ElementIndex grain = ElementRegistry::EMPTY_INDEX;
+    uint64_t empty = 0;
+    uint64_t grains = 0;
+    for (int i = 0; i < n; ++i) {
+        const ElementIndex type = row[i];
+        if (type == ElementRegistry::EMPTY_INDEX) {
+            empty |= uint64_t { 1 } << i;
+            continue;
+        }
+        if (i == 0 || i == n - 1 || !registry.is_movable(type))
+            continue;
+        if (grain == ElementRegistry::EMPTY_INDEX) {
+            if (registry.get_kind(type) != ElementKind::MovableSolid)
+                return false;
+            grain = type;
+        } else if (type != grain) {
+            return false;
+        }
+        grains |= uint64_t { 1 } << i;
+    }
+    if (grains == 0)
+        return false;
+    const int density = registry.get_density(grain);
+    if (density <= registry.get_density(ElementRegistry::EMPTY_INDEX))
+        return false;
+
+    // Row y + 1: empty cells a grain may enter; anything else has to be beyond its reach
+    const ElementIndex *below = types + cells.flatten_coords(origin, y + 1);
+    uint64_t sink = 0;
+    for (int i = 0; i < n; ++i) {
+        const ElementIndex type = below[i];
+        if (type == ElementRegistry::EMPTY_INDEX) {
+            sink |= uint64_t { 1 } << i;
+        } else if (registry.get_kind(type) != ElementKind::ImmovableSolid && registry.get_density(type) < density) {
+            return false; // The grain would swap with it
+        }
+    }
+    const uint64_t taken = cells.get_written_mask(origin, y + 1, n);
+
+    // In place, a grain written this tick has already moved
+    const uint64_t stepped = grains & ~cells.get_written_mask(origin, y, n);
+    const uint64_t falls = stepped & sink & ~taken;
+    const uint64_t blocked = stepped & ~falls;
+    const int blocked_count = std::popcount(blocked);
+    const uint64_t flips = RandomUtils::coin_flips(blocked_count);
+
+    // A blocked grain can only slide beside an empty cell over an empty one, or beside a grain
+    // that may slide away from such a cell first
+    const uint64_t openings = (empty | (blocked & sink & taken)) & sink;
+    uint64_t candidates = blocked & ((openings << 1) | (openings >> 1));
+    uint64_t vacated = 0;
+    uint64_t claimed = 0; // Cells below filled by this span's slides
+    uint64_t slid_left = 0;
+    uint64_t slid_right = 0;
+    while (candidates) {
+        const int x = scan_left_to_right ? std::countr_zero(candidates) : 63 - std::countl_zero(candidates);
+        candidates &= ~(uint64_t { 1 } << x);
+        // One flip per blocked grain, in scan order
+        const uint64_t earlier = scan_left_to_right ? blocked & ((uint64_t { 1 } << x) - 1) : blocked >> (x + 1);
+        const bool right_first = (flips >> std::popcount(earlier)) & 1;
+        const int dirs[2] = { right_first ? 1 : -1, right_first ? -1 : 1 };
+        for (const int dir : dirs) {
+            const uint64_t side = uint64_t { 1 } << (x + dir);
+            // As in try_solid_diagonal_movement: a direction that is shut is skipped, including a
+            // target another grain just slid into (equal density cannot be displaced), but an
+            // empty target written earlier this tick ends the attempt
+            if (!((empty | vacated) & sink & side) || (claimed & side))
+                continue;
+            if (taken & side)
+                break;
+            claimed |= side;
+            vacated |= uint64_t { 1 } << x;
+            (dir < 0 ? slid_left : slid_right) |= uint64_t { 1 } << x;
+            break;
+        }
+    }
+
+    // Falls and slides never share a source or a target, so the order they are applied in is free
+    cells.move_down(origin, y, falls, 0);
+    cells.move_down(origin, y, slid_left, -1);
+    cells.move_down(origin, y, slid_right, 1);
+    const int slides = std::popcount(vacated);
+
+    report.type = grain;
+    report.stats = MovementStats();
+    report.stats.cells_stepped = std::popcount(stepped);
+    report.stats.moves = std::popcount(falls) + slides;
+    report.stats.failed[static_cast<int>(MovementRoutine::TRY_MOVE)] = blocked_count;
+    report.stats.failed[static_cast<int>(MovementRoutine::TRY_SOLID_DIAGONAL_MOVEMENT)] = blocked_count - slides;
+    return true;
+}
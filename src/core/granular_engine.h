@@ -0,0 +1,51 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_GRANULAR_ENGINE_H
+#define SANDSTONE_GRANULAR_ENGINE_H
+
+#include "../elements/element_type.h"
+#include "../utils/movement_stats.h"
+
+class CellMatrix;
+
+/**
+ * @brief Steps a row span of one movable solid with 64-bit masks instead of cell by cell.
+ *
+ * A span qualifies when its movable cells are all of a single MovableSolid element and the
+ * row below (one cell past the span on each side) holds only EMPTY or cells that element
+ * cannot displace. There a grain can only fall into an empty cell or slide diagonally into
+ * one, which needs no density checks per cell:
+ *
+ * - Falls are one mask: grains over an unwritten empty cell. No other grain of the row can
+ *   take the cell below a grain first.
+ * - Every grain that cannot fall draws one coin flip for its slide order, as MovableSolid does;
+ *   all of them are drawn at once.
+ * - Slides only depend on the neighbours already handled in scan order, so the grains next to
+ *   an empty column are resolved in a short loop over bits; the rest cannot move.
+ *
+ * Moves are then applied a mask at a time. The outcome, random stream and woken chunks
+ * included, is the same as stepping the cells one by one with MovableSolid::step in place, so
+ * hashes match the other dispatches. Spans that do not qualify are left to the per-cell path.
+ */
+class GranularEngine {
+public:
+    // Widest span handled: the span and one neighbour on each side fit in one word
+    static constexpr int MAX_SPAN = 62;
+
+    // What one handled span did, for the movement stats and the profiler
+    struct Report {
+        ElementIndex type = 0;
+        MovementStats stats;
+    };
+
+    /**
+     * @brief Step the cells of row `y` in [min_x, max_x] in place, in the given scan order.
+     * @return false, with nothing changed and no randomness drawn, if the span does not qualify.
+     */
+    static bool step_span(CellMatrix &cells, int y, int min_x, int max_x, bool scan_left_to_right,
+        Report &report);
+};
+
+#endif //SANDSTONE_GRANULAR_ENGINE_H
@@ -0,0 +1,146 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "heat_diffusion.h"
+#include "cell_matrix.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+void HeatDiffusion::step(CellMatrix &cells, ThreadPool *pool)
+{
+    const int height = cells.get_height();
+    if (cells.get_width() == 0 || height == 0)
+        return;
+
+    // Planes cover the padded grid. The wall border never changes temperature, so seeding the
+    // output plane with a copy once keeps its border valid across every later swap.
+    const size_t total = static_cast<size_t>(cells.get_stride()) * (height + 2 * CellMatrix::PADDING);
+    if (_next_temps.size() != total)
+        _next_temps.assign(cells.get_temp_plane(), cells.get_temp_plane() + total);
+    _conductivity.resize(total);
+    _inv_heat_capacity.resize(total);
+
+    const int bands = (height + BAND_ROWS - 1) / BAND_ROWS;
+    resize_bands(bands);
+    const auto is_active = [&](const int band) { return band >= 0 && band < bands && _band_active[band]; };
+    const auto is_stepped = [&](const int band) { return band >= 0 && band < bands && _band_stepped[band]; };
+    for (int band = 0; band < bands; ++band) {
+        _band_stepped[band] = is_active(band - 1) || is_active(band) || is_active(band + 1);
+    }
+
+    // The stencil reads one row past a band on each side; the rows above and below the grid
+    // are wall rows. Every band must be gathered before any band is diffused.
+    const auto gather_band = [&](const int band) {
+        if (!is_stepped(band - 1) && !is_stepped(band) && !is_stepped(band + 1))
+            return;
+        const int begin = band == 0 ? -1 : band * BAND_ROWS;
+        const int end = band == bands - 1 ? height + 1 : (band + 1) * BAND_ROWS;
+        gather_properties(cells, begin, end);
+    };
+    // Bands left out still publish their rows, unchanged
+    const auto diffuse_band = [&](const int band) {
+        const int begin = band * BAND_ROWS;
+        const int end = std::min(height, (band + 1) * BAND_ROWS);
+        if (_band_stepped[band]) {
+            _band_active[band] = diffuse_rows(cells, begin, end);
+        } else {
+            copy_rows(cells, begin, end);
+        }
+    };
+    if (pool) {
+        pool->parallel_for(bands, gather_band);
+        pool->parallel_for(bands, diffuse_band);
+    } else {
+        for (int band = 0; band < bands; ++band) {
+            gather_band(band);
+        }
+        for (int band = 0; band < bands; ++band) {
+            diffuse_band(band);
+        }
+    }
+
+    cells.swap_temp_plane(_next_temps);
+}
+
+void HeatDiffusion::note_activity(const ChunkMap &chunks)
+{
+    const int bands = chunks.get_chunks_y();
+    resize_bands(bands);
+    for (int cy = 0; cy < bands; ++cy) {
+        for (int cx = 0; cx < chunks.get_chunks_x() && !_band_active[cy]; ++cx) {
+            _band_active[cy] = chunks.is_awake(cx, cy);
+        }
+    }
+}
+
+void HeatDiffusion::resize_bands(const int bands)
+{
+    // A new grid starts with every band active
+    if (_band_active.size() != static_cast<size_t>(bands)) {
+        _band_active.assign(bands, 1);
+        _band_stepped.assign(bands, 1);
+    }
+}
+
+void HeatDiffusion::gather_properties(const CellMatrix &cells, const int row_begin, const int row_end)
+{
+    const ElementRegistry &registry = cells.get_registry();
+    const ElementIndex *types = cells.get_type_plane();
+    const int begin = cells.flatten_coords(-CellMatrix::PADDING, row_begin);
+    const int end = cells.flatten_coords(-CellMatrix::PADDING, row_end);
+    for (int i = begin; i < end; ++i) {
+        _conductivity[i] = registry.get_conductivity(types[i]);
+        _inv_heat_capacity[i] = registry.get_inv_heat_capacity(types[i]);
+    }
+}
+
+bool HeatDiffusion::diffuse_rows(const CellMatrix &cells, const int row_begin, const int row_end)
+{
+    const int width = cells.get_width();
+    const int stride = cells.get_stride();
+    const float *temps = cells.get_temp_plane();
+
+    int changed = 0;
+    for (int y = row_begin; y < row_end; ++y) {
+        // Neighbours past the edge are walls with zero conductivity, so the border needs no
+        // special case. No aliasing between the output row and the inputs lets this vectorise.
+        const int row = cells.flatten_coords(0, y);
+        const float *__restrict t = temps + row;
+        const float *__restrict tu = t - stride;
+        const float *__restrict td = t + stride;
+        const float *__restrict k = _conductivity.data() + row;
+        const float *__restrict ku = k - stride;
+        const float *__restrict kd = k + stride;
+        const float *__restrict inv_c = _inv_heat_capacity.data() + row;
+        float *__restrict out = _next_temps.data() + row;
+
+        for (int x = 0; x < width; ++x) {
+            const float tc = t[x];
+            const float flux =
+                k[x - 1] * (t[x - 1] - tc) +
+                k[x + 1] * (t[x + 1] - tc) +
+                ku[x] * (tu[x] - tc) +
+                kd[x] * (td[x] - tc);
+            out[x] = tc + RATE * k[x] * inv_c[x] * flux;
+            // Settled means every conducting neighbour within SETTLED_DELTA, whatever the
+            // materials; their damped exchange can be far smaller. Integer or-reductions
+            // vectorise where a float max would not.
+            const int conducts = static_cast<int>(k[x] > 0.0f);
+            changed |= conducts & static_cast<int>(k[x - 1] > 0.0f) & static_cast<int>(std::fabs(t[x - 1] - tc) > SETTLED_DELTA);
+            changed |= conducts & static_cast<int>(k[x + 1] > 0.0f) & static_cast<int>(std::fabs(t[x + 1] - tc) > SETTLED_DELTA);
+            changed |= conducts & static_cast<int>(ku[x] > 0.0f) & static_cast<int>(std::fabs(tu[x] - tc) > SETTLED_DELTA);
+            changed |= conducts & static_cast<int>(kd[x] > 0.0f) & static_cast<int>(std::fabs(td[x] - tc) > SETTLED_DELTA);
+        }
+    }
+    return changed != 0;
+}
+
+void HeatDiffusion::copy_rows(const CellMatrix &cells, const int row_begin, const int row_end)
+{
+    const int begin = cells.flatten_coords(0, row_begin);
+    const int end = cells.flatten_coords(0, row_end);
+    std::copy(cells.get_temp_plane() + begin, cells.get_temp_plane() + end, _next_temps.data() + begin);
+}
@@ -0,0 +1,62 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_HEAT_DIFFUSION_H
+#define SANDSTONE_HEAT_DIFFUSION_H
+
+#include "chunk_map.h"
+
+#include <cstdint>
+#include <vector>
+
+class CellMatrix;
+class ThreadPool;
+
+/**
+ * @brief Explicit 5-point conduction stencil over the temperature plane.
+ *
+ * Each pass first gathers per-cell conductivity and inverse heat capacity from the registry
+ * tables into flat float planes, then updates every row with a branch-free inner loop the
+ * compiler can vectorise. Heat flowing between two cells is proportional to the product of
+ * their conductivities, so the exchange is symmetric. Grid borders are insulated.
+ *
+ * Work is skipped where the temperature field has settled: the grid is cut into bands of
+ * BAND_ROWS rows, and a band is only stepped when it or a neighbouring band still had two
+ * conducting neighbours more than SETTLED_DELTA apart at its last step, or had cells move
+ * (see note_activity()).
+ */
+class HeatDiffusion {
+public:
+    // Exchange rate per neighbour at full conductivity. Four neighbours sum to at most 0.8,
+    // which keeps every new temperature within the range of its neighbourhood.
+    static constexpr float RATE = 0.2f;
+    // Rows per band, one chunk row so chunk activity maps onto bands directly
+    static constexpr int BAND_ROWS = ChunkMap::CHUNK_SIZE;
+    // Largest difference, in degrees, between conducting neighbours of a settled band
+    static constexpr float SETTLED_DELTA = 1e-3f;
+
+    /**
+     * @brief Run one conduction step over the whole grid.
+     * @param pool Optional worker pool; rows are split into bands across its threads.
+     */
+    void step(CellMatrix &cells, ThreadPool *pool);
+
+    // Keep the bands of every awake chunk active; call once per tick, after the particle scan
+    void note_activity(const ChunkMap &chunks);
+
+private:
+    void resize_bands(int bands);
+    void gather_properties(const CellMatrix &cells, int row_begin, int row_end);
+    // Returns whether the rows are still unsettled (see SETTLED_DELTA)
+    bool diffuse_rows(const CellMatrix &cells, int row_begin, int row_end);
+    void copy_rows(const CellMatrix &cells, int row_begin, int row_end);
+
+    std::vector<float> _conductivity;
+    std::vector<float> _inv_heat_capacity;
+    std::vector<float> _next_temps;
+    std::vector<uint8_t> _band_active; // Unsettled, or had cells move, since its last step
+    std::vector<uint8_t> _band_stepped; // Stepped this pass
+};
+
+#endif //SANDSTONE_HEAT_DIFFUSION_H
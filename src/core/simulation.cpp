@@ -1,57 +1,417 @@
 #include "simulation.h"
+#include "edit_journal.h"
+#include "granular_engine.h"
+#include "../elements/types/gas.h"
+#include "../elements/types/liquid.h"
+#include "../elements/types/movable_solid.h"
+#include "../utils/profiler.h"
+#include "../utils/random_utils.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 #include <utility>
 
-Simulation::Simulation(const int width, const int height, ElementRegistry& element_registry)
-    : _element_registry(element_registry)
+Simulation::Simulation(const int width, const int height, SharedElementRegistry element_registry)
+    : _element_registry(std::move(element_registry))
 {
     _width = width;
     _height = height;
-    _cells = CellMatrix(width, height, _element_registry);
-    _next_cells = CellMatrix(width, height, _element_registry);
+    _cells = CellMatrix(width, height, *_element_registry);
+    _dirty_rects.resize(_cells.get_chunks().get_chunks_x() * _cells.get_chunks().get_chunks_y());
+    mark_all_dirty();
 }
 
-Simulation::Simulation(const Vector2I &size, ElementRegistry& element_registry)
-    : Simulation(size.x, size.y, element_registry) { }
+Simulation::Simulation(const Vector2I &size, SharedElementRegistry element_registry)
+    : Simulation(size.x, size.y, std::move(element_registry)) { }
 
 void Simulation::step()
 {
-    _next_cells = _cells;
-    _next_cells.begin_tick();
+    // Edits made since the last tick are about to be promoted out of the pending rects
+    collect_dirty_rects();
+    tick();
+    collect_dirty_rects();
+}
+
+int Simulation::step_n(const int ticks, const int settled_awake_chunks)
+{
+    int ran = 0;
+    while (ran < ticks) {
+        tick();
+        ++ran;
+        if (settled_awake_chunks >= 0 && get_awake_chunk_count() <= settled_awake_chunks)
+            break;
+    }
+    // The per-tick dirty rects were skipped, so whoever paints next starts from scratch
+    mark_all_dirty();
+    return ran;
+}
+
+void Simulation::tick()
+{
+    const ProfileScope tick_scope(ProfilePhase::TICK);
+    _profiling = Profiler::is_enabled();
+    _instrumented = _profiling || _movement_stats_enabled;
+
+    if (_seeded)
+        RandomUtils::reseed(_seed + static_cast<uint32_t>(_step_count) * 0x9E3779B9u);
+
+    if (_step_scheme == StepScheme::DOUBLE_BUFFERED) {
+        const ProfileScope copy_scope(ProfilePhase::BUFFER_COPY);
+        _next_cells = _cells;
+        _write_cells = &_next_cells;
+    } else {
+        _write_cells = &_cells;
+    }
+    _write_cells->begin_tick();
+    _write_cells->set_concurrent_writes(_thread_pool != nullptr);
     
     // Alternate scan direction each frame to reduce processing order bias
     const bool scan_left_to_right = (_step_count % 2) == 0;
+
+    {
+        const ProfileScope scan_scope(ProfilePhase::PARTICLE_SCAN);
+        if (_thread_pool) {
+            step_checkerboard(scan_left_to_right);
+        } else {
+            step_serial(scan_left_to_right);
+        }
+    }
+    if (_movement_stats_enabled)
+        merge_movement_stats();
+
+    if (_step_scheme == StepScheme::DOUBLE_BUFFERED) {
+        // Swapped rather than moved, so the next tick copies into the old buffer's storage
+        std::swap(_cells, _next_cells);
+        _write_cells = &_cells;
+    }
+
+    if (_heat_interval > 0) {
+        // Every tick, so moves between two heat steps are not missed
+        _heat.note_activity(_cells.get_chunks());
+        if (_step_count % _heat_interval == 0) {
+            const ProfileScope heat_scope(ProfilePhase::HEAT);
+            _heat.step(_cells, _thread_pool.get());
+        }
+    }
+
+    if (_profiling)
+        Profiler::end_tick();
+    _step_count++;
+}
+
+void Simulation::step_serial(const bool scan_left_to_right)
+{
+    // Only the dirty rects of awake chunks are scanned. Rows still go bottom to top across
+    // the whole grid so the processing order matches a full scan.
+    const ChunkMap &chunks = _write_cells->get_chunks();
+    const int chunks_x = chunks.get_chunks_x();
     
     for (int y = _height - 1; y >= 0; --y) {
-        if (scan_left_to_right) {
-            // Left to right scan
-            for (int x = 0; x < _width; ++x) {
-                if (const ElementType *type = _cells.get_type(x, y)) {
-                    type->step_particle_at(_cells, _next_cells, x, y, type);
+        const int cy = y / ChunkMap::CHUNK_SIZE;
+        for (int i = 0; i < chunks_x; ++i) {
+            const int cx = scan_left_to_right ? i : chunks_x - 1 - i;
+            const Rect2I &dirty = chunks.get_dirty_rect(cx, cy);
+            if (y < dirty.min_y || y > dirty.max_y)
+                continue;
+
+            step_span(y, dirty.min_x, dirty.max_x, scan_left_to_right);
+        }
+    }
+    if (_profiling)
+        Profiler::flush_cells();
+}
+
+void Simulation::step_checkerboard(const bool scan_left_to_right)
+{
+    const ChunkMap &chunks = _write_cells->get_chunks();
+    const int chunks_x = chunks.get_chunks_x();
+    const int chunks_y = chunks.get_chunks_y();
+
+    // Bottom phases first, mirroring the bottom-to-top order of the serial scan
+    for (int phase_y = 1; phase_y >= 0; --phase_y) {
+        for (int phase_x = 0; phase_x < 2; ++phase_x) {
+            _phase_chunks.clear();
+            for (int cy = phase_y; cy < chunks_y; cy += 2) {
+                for (int cx = phase_x; cx < chunks_x; cx += 2) {
+                    if (chunks.is_awake(cx, cy))
+                        _phase_chunks.push_back(cy * chunks_x + cx);
                 }
             }
+
+            _thread_pool->parallel_for(static_cast<int>(_phase_chunks.size()), [&](const int i) {
+                const int chunk = _phase_chunks[i];
+                step_chunk(chunk % chunks_x, chunk / chunks_x, scan_left_to_right);
+            });
+        }
+    }
+}
+
+void Simulation::step_chunk(const int cx, const int cy, const bool scan_left_to_right)
+{
+    const Rect2I &dirty = _write_cells->get_chunks().get_dirty_rect(cx, cy);
+    for (int y = dirty.max_y; y >= dirty.min_y; --y) {
+        step_span(y, dirty.min_x, dirty.max_x, scan_left_to_right);
+    }
+    if (_profiling)
+        Profiler::flush_cells();
+}
+
+void Simulation::step_span(const int y, const int min_x, const int max_x, const bool scan_left_to_right)
+{
+    if (_step_dispatch == StepDispatch::BITBOARD && _write_cells == &_cells
+        && step_granular_span(y, min_x, max_x, scan_left_to_right))
+        return;
+
+    // Only movable cells are visited, found through the occupancy bitmap a word at a time.
+    // A word is read once: cells that turn movable later in the scan were just written by a
+    // move, and step_cell would skip them anyway.
+    const int first_word = min_x / 64;
+    const int last_word = max_x / 64;
+    for (int i = first_word; i <= last_word; ++i) {
+        const int w = scan_left_to_right ? i : first_word + last_word - i;
+        const int base = w * 64;
+        const int lo = std::max(min_x, base) - base;
+        const int hi = std::min(max_x, base + 63) - base;
+        const uint64_t span_mask = (~uint64_t { 0 } << lo) & (~uint64_t { 0 } >> (63 - hi));
+        uint64_t bits = _cells.get_movable_word(y, w) & span_mask;
+
+        if (scan_left_to_right) {
+            while (bits) {
+                const int bit = std::countr_zero(bits);
+                bits &= bits - 1;
+                step_cell(base + bit, y);
+            }
         } else {
-            // Right to left scan
-            for (int x = _width - 1; x >= 0; --x) {
-                if (const ElementType *type = _cells.get_type(x, y)) {
-                    type->step_particle_at(_cells, _next_cells, x, y, type);
-                }
+            while (bits) {
+                const int bit = 63 - std::countl_zero(bits);
+                bits &= ~(uint64_t { 1 } << bit);
+                step_cell(base + bit, y);
             }
         }
     }
+}
 
-    _cells = std::move(_next_cells);
-    _step_count++;
+bool Simulation::step_granular_span(const int y, const int min_x, const int max_x, const bool scan_left_to_right)
+{
+    GranularEngine::Report report;
+    if (!_instrumented)
+        return GranularEngine::step_span(_cells, y, min_x, max_x, scan_left_to_right, report);
+
+    const int64_t begin_ns = _profiling ? Profiler::now_ns() : 0;
+    if (!GranularEngine::step_span(_cells, y, min_x, max_x, scan_left_to_right, report))
+        return false;
+    if (_profiling) {
+        Profiler::add_cell_batch(ElementKind::MovableSolid, static_cast<int>(report.stats.cells_stepped),
+            Profiler::now_ns() - begin_ns);
+    }
+    if (_movement_stats_enabled) {
+        const int worker = _thread_pool ? _thread_pool->get_worker_index() : 0;
+        _thread_movement_stats[worker][report.type].merge(report.stats);
+    }
+    return true;
+}
+
+void Simulation::step_cell(const int x, const int y)
+{
+    // In place, a cell written this tick holds a particle that already moved
+    if (_write_cells == &_cells && _cells.is_written(x, y))
+        return;
+
+    if (_instrumented) [[unlikely]] {
+        step_cell_instrumented(x, y);
+        return;
+    }
+    update_cell(x, y);
+}
+
+void Simulation::step_cell_instrumented(const int x, const int y)
+{
+    if (_movement_stats_enabled) {
+        const int worker = _thread_pool ? _thread_pool->get_worker_index() : 0;
+        MovementStats &stats = _thread_movement_stats[worker][_cells.get_index(x, y)];
+        stats.cells_stepped++;
+        MovementStats::current = &stats;
+    }
+
+    const ElementKind kind = _cells.get_kind(x, y);
+    if (_profiling && Profiler::count_cell(kind)) {
+        const int64_t begin_ns = Profiler::now_ns();
+        update_cell(x, y);
+        Profiler::add_cell_sample(kind, Profiler::now_ns() - begin_ns);
+    } else {
+        update_cell(x, y);
+    }
+    MovementStats::current = nullptr;
+}
+
+void Simulation::update_cell(const int x, const int y)
+{
+    if (_step_dispatch == StepDispatch::VIRTUAL) {
+        if (const ElementType *type = _cells.get_type(x, y)) {
+            type->step_particle_at(_cells, *_write_cells, x, y, type);
+        }
+        return;
+    }
+
+    switch (_cells.get_kind(x, y)) {
+        case ElementKind::MovableSolid:
+            MovableSolid::step(_cells, *_write_cells, x, y);
+            break;
+        case ElementKind::Liquid:
+            Liquid::step(_cells, *_write_cells, x, y);
+            break;
+        case ElementKind::Gas:
+            Gas::step(_cells, *_write_cells, x, y);
+            break;
+        default: // Empty, ImmovableSolid and Unknown never move
+            break;
+    }
+}
+
+void Simulation::set_thread_count(const int count)
+{
+    if (count <= 1) {
+        _thread_pool.reset();
+    } else if (!_thread_pool || _thread_pool->get_thread_count() != count) {
+        _thread_pool = std::make_unique<ThreadPool>(count);
+    }
+    if (_movement_stats_enabled)
+        _thread_movement_stats.resize(get_thread_count(), std::vector<MovementStats>(_tick_movement_stats.size()));
+}
+
+int Simulation::get_thread_count() const
+{
+    return _thread_pool ? _thread_pool->get_thread_count() : 1;
+}
+
+void Simulation::set_movement_stats_enabled(const bool enabled)
+{
+    _movement_stats_enabled = enabled;
+    reset_movement_stats();
+}
+
+bool Simulation::is_movement_stats_enabled() const
+{
+    return _movement_stats_enabled;
+}
+
+const std::vector<MovementStats>& Simulation::get_tick_movement_stats() const
+{
+    return _tick_movement_stats;
+}
+
+const std::vector<MovementStats>& Simulation::get_total_movement_stats() const
+{
+    return _total_movement_stats;
+}
+
+void Simulation::reset_movement_stats()
+{
+    // The wall index is one past the last type; it never moves but keeps indexing in range
+    const size_t elements = _movement_stats_enabled ? _element_registry->get_type_count() + 1 : 0;
+    const size_t workers = _movement_stats_enabled ? get_thread_count() : 0;
+    _thread_movement_stats.assign(workers, std::vector<MovementStats>(elements));
+    _tick_movement_stats.assign(elements, MovementStats());
+    _total_movement_stats.assign(elements, MovementStats());
+}
+
+void Simulation::merge_movement_stats()
+{
+    std::ranges::fill(_tick_movement_stats, MovementStats());
+    for (std::vector<MovementStats> &table : _thread_movement_stats) {
+        for (size_t i = 0; i < table.size(); ++i) {
+            _tick_movement_stats[i].merge(table[i]);
+            table[i] = MovementStats();
+        }
+    }
+    for (size_t i = 0; i < _tick_movement_stats.size(); ++i) {
+        _total_movement_stats[i].merge(_tick_movement_stats[i]);
+    }
+}
+
+void Simulation::set_step_scheme(const StepScheme scheme)
+{
+    _step_scheme = scheme;
+    if (scheme == StepScheme::IN_PLACE)
+        _next_cells = CellMatrix();
+}
+
+StepScheme Simulation::get_step_scheme() const
+{
+    return _step_scheme;
+}
+
+void Simulation::set_step_dispatch(const StepDispatch dispatch)
+{
+    _step_dispatch = dispatch;
+}
+
+StepDispatch Simulation::get_step_dispatch() const
+{
+    return _step_dispatch;
+}
+
+void Simulation::set_heat_interval(const int ticks)
+{
+    _heat_interval = std::max(0, ticks);
+}
+
+int Simulation::get_heat_interval() const
+{
+    return _heat_interval;
+}
+
+void Simulation::set_seed(const uint32_t seed)
+{
+    _seeded = true;
+    _seed = seed;
+}
+
+bool Simulation::is_seeded() const
+{
+    return _seeded;
+}
+
+uint32_t Simulation::get_seed() const
+{
+    return _seed;
+}
+
+void Simulation::set_journal(EditJournal *journal)
+{
+    _journal = journal;
+}
+
+int Simulation::get_step_count() const
+{
+    return _step_count;
+}
+
+void Simulation::set_step_count(const int count)
+{
+    _step_count = count;
+}
+
+uint64_t Simulation::get_state_hash() const
+{
+    return _cells.get_state_hash();
 }
 
 bool Simulation::set_type_at(const int x, const int y,
     const ElementType *type, const int color_idx)
 {
-    if (!is_pos_within_bounds(x, y))
+    if (!is_pos_within_bounds(x, y) || type == nullptr)
         return false;
 
-    _cells.get(x, y).type = type;
+    if (_journal)
+        _journal->record(_step_count, x, y, type->get_index(), color_idx);
+
+    _cells.set_type(x, y, type);
+    _cells.set_temp(x, y, static_cast<float>(type->get_temperature()));
     if (color_idx > -1)
         _cells.set_color_variation_index(x, y, color_idx);
+    _cells.wake(x, y);
     return true;
 }
 
@@ -63,12 +423,12 @@ bool Simulation::set_type_at(const Vector2I &pos, const ElementType *type, const
 bool Simulation::set_type_at(const int x, const int y,
                              const std::string &id, const int color_idx)
 {
-    return set_type_at(x, y, _element_registry.get_type_by_id(id), color_idx);
+    return set_type_at(x, y, _element_registry->get_type_by_id(id), color_idx);
 }
 
 bool Simulation::set_type_at(const Vector2I &pos, const std::string &id, const int color_idx)
 {
-    return set_type_at(pos, _element_registry.get_type_by_id(id), color_idx);
+    return set_type_at(pos, _element_registry->get_type_by_id(id), color_idx);
 }
 
 const ElementType* Simulation::get_type_at(const int x, const int y) const
@@ -84,41 +444,170 @@ const ElementType * Simulation::get_type_at(const Vector2I &pos) const
     return get_type_at(pos.x, pos.y);
 }
 
+CellData Simulation::get_cell(const int x, const int y) const
+{
+    return _cells.get(x, y);
+}
+
+void Simulation::set_cell(const int x, const int y, const CellData &cell)
+{
+    _cells.set(x, y, cell);
+}
+
+void Simulation::wake_all()
+{
+    _cells.wake_all();
+    mark_all_dirty();
+}
+
 void Simulation::fill_render_buffer(Color *dst) const
 {
-    const int total = _width * _height;
-    for (int i = 0; i < total; ++i) {
-        if (const auto type = _cells.get_type(i)) {
-            dst[i] = type->get_color(_cells.get_color_variation_index(i));
-        } else {
-            dst[i] = { 0, 0, 0, 0 }; // Black for null types
-        }
+    fill_render_rect(dst, Rect2I(0, 0, _width - 1, _height - 1));
+}
+
+// Rows per parallel work item of the colour passes
+static constexpr int FILL_BAND_ROWS = 64;
+
+// Run fill(row_begin, row_end) over [0, rows), split into bands when a pool is available
+template <typename Fill>
+static void fill_rows(ThreadPool *pool, const int rows, const Fill &fill)
+{
+    if (!pool || rows < 2 * FILL_BAND_ROWS) {
+        fill(0, rows);
+        return;
     }
+    const int bands = (rows + FILL_BAND_ROWS - 1) / FILL_BAND_ROWS;
+    pool->parallel_for(bands, [&](const int band) {
+        fill(band * FILL_BAND_ROWS, std::min(rows, (band + 1) * FILL_BAND_ROWS));
+    });
 }
 
-static unsigned char lerp_uc(const unsigned char a, const unsigned char b, const float t)
+// The row kernels are branch-free gathers from a packed table and take __restrict pointers so
+// they can vectorise (with hardware gathers where the target has them)
+static void fill_palette_row(Color *__restrict out, const ElementIndex *__restrict types,
+    const uint8_t *__restrict variants, const uint32_t *__restrict palette, const int shift, const int width)
 {
-    return static_cast<unsigned char>(a + (b - a) * t);
+    for (int x = 0; x < width; ++x) {
+        const uint32_t packed = palette[(types[x] << shift) | variants[x]];
+        std::memcpy(&out[x], &packed, sizeof(packed));
+    }
 }
 
-void Simulation::fill_temperature_buffer(Color *dst, const Color cold, const Color hot, const int t_min, const int t_max) const
+static void fill_colormap_row(Color *__restrict out, const ElementIndex *__restrict types,
+    const float *__restrict temps, const uint32_t *__restrict colormap, const float t_min, const float t_max,
+    const float scale, const int width)
 {
-    const int total = _width * _height;
-    const float span = static_cast<float>(std::max(1, t_max - t_min));
-    for (int i = 0; i < total; ++i) {
-        const ElementType *type = _cells.get_type(i);
-        if (!type || type->get_kind() == ElementKind::Empty) {
-            dst[i] = { 0, 0, 0, 255 };
-            continue;
+    for (int x = 0; x < width; ++x) {
+        const float t = std::min(std::max(temps[x], t_min), t_max) - t_min;
+        const int heat = static_cast<int>(t * scale);
+        // Empty cells take the last entry; a mask rather than a ternary keeps the loop if-converted
+        const int empty = -static_cast<int>(types[x] == ElementRegistry::EMPTY_INDEX);
+        const int entry = (heat & ~empty) | (Simulation::TEMPERATURE_LUT_SIZE & empty);
+        const uint32_t packed = colormap[entry];
+        std::memcpy(&out[x], &packed, sizeof(packed));
+    }
+}
+
+void Simulation::fill_render_rect(Color *dst, const Rect2I &rect) const
+{
+    paint_rect(dst, rect.get_width(), rect);
+}
+
+void Simulation::fill_render_rect(Color *dst, const int dst_stride, const Rect2I &rect) const
+{
+    paint_rect(dst + static_cast<size_t>(rect.min_y) * dst_stride + rect.min_x, dst_stride, rect);
+}
+
+void Simulation::paint_rect(Color *origin, const int stride, const Rect2I &rect) const
+{
+    const uint32_t *palette = _element_registry->get_packed_palette();
+    const int shift = _element_registry->get_packed_palette_shift();
+    const int w = rect.get_width();
+    fill_rows(_thread_pool.get(), rect.get_height(), [&](const int row_begin, const int row_end) {
+        for (int r = row_begin; r < row_end; ++r) {
+            const int row = _cells.flatten_coords(rect.min_x, rect.min_y + r);
+            fill_palette_row(origin + static_cast<size_t>(r) * stride, _cells.get_type_plane() + row,
+                _cells.get_color_variation_plane() + row, palette, shift, w);
         }
-        const int t = _cells.get_temp(i);
-        const float tt = std::clamp((t - t_min) / span, 0.0f, 1.0f);
-        dst[i] = {
-            lerp_uc(cold.r, hot.r, tt),
-            lerp_uc(cold.g, hot.g, tt),
-            lerp_uc(cold.b, hot.b, tt),
+    });
+}
+
+void Simulation::fill_temperature_buffer(Color *dst, const Color cold, const Color hot, const int t_min, const int t_max) const
+{
+    // Colormap sampled once per call; the extra last entry is the colour of empty cells
+    std::array<uint32_t, TEMPERATURE_LUT_SIZE + 1> lut {};
+    for (int i = 0; i < TEMPERATURE_LUT_SIZE; ++i) {
+        const float t = static_cast<float>(i) / (TEMPERATURE_LUT_SIZE - 1);
+        const Color c {
+            static_cast<unsigned char>(cold.r + (hot.r - cold.r) * t),
+            static_cast<unsigned char>(cold.g + (hot.g - cold.g) * t),
+            static_cast<unsigned char>(cold.b + (hot.b - cold.b) * t),
             255
         };
+        std::memcpy(&lut[i], &c, sizeof(uint32_t));
+    }
+    constexpr Color EMPTY_COLOR { 0, 0, 0, 255 };
+    std::memcpy(&lut[TEMPERATURE_LUT_SIZE], &EMPTY_COLOR, sizeof(uint32_t));
+
+    const int t_hi = std::max(t_min + 1, t_max);
+    const float scale = static_cast<float>(TEMPERATURE_LUT_SIZE - 1) / static_cast<float>(t_hi - t_min);
+    fill_rows(_thread_pool.get(), _height, [&](const int row_begin, const int row_end) {
+        for (int y = row_begin; y < row_end; ++y) {
+            const int row = _cells.flatten_coords(0, y);
+            fill_colormap_row(dst + static_cast<size_t>(y) * _width, _cells.get_type_plane() + row,
+                _cells.get_temp_plane() + row, lut.data(), static_cast<float>(t_min), static_cast<float>(t_hi), scale, _width);
+        }
+    });
+}
+
+int Simulation::get_awake_chunk_count() const
+{
+    return _cells.get_chunks().count_awake();
+}
+
+void Simulation::collect_dirty_rects()
+{
+    const ChunkMap &chunks = _cells.get_chunks();
+    for (int cy = 0; cy < chunks.get_chunks_y(); ++cy) {
+        for (int cx = 0; cx < chunks.get_chunks_x(); ++cx) {
+            _dirty_rects[cy * chunks.get_chunks_x() + cx].include(chunks.get_pending_rect(cx, cy));
+        }
+    }
+}
+
+std::vector<Rect2I> Simulation::take_dirty_rects()
+{
+    collect_dirty_rects();
+
+    std::vector<Rect2I> rects;
+    const int chunks_x = _cells.get_chunks().get_chunks_x();
+    for (size_t i = 0; i < _dirty_rects.size(); ++i) {
+        Rect2I &rect = _dirty_rects[i];
+        if (rect.is_empty())
+            continue;
+        // Runs of dirty chunks along a chunk row become one upload
+        if (i % chunks_x != 0 && !_dirty_rects[i - 1].is_empty() && !rects.empty()) {
+            rects.back().include(rect);
+        } else {
+            rects.push_back(rect);
+        }
+    }
+    for (Rect2I &rect : _dirty_rects) {
+        rect.clear();
+    }
+    return rects;
+}
+
+void Simulation::mark_all_dirty()
+{
+    const int chunks_x = _cells.get_chunks().get_chunks_x();
+    for (size_t i = 0; i < _dirty_rects.size(); ++i) {
+        const int cx = static_cast<int>(i) % chunks_x;
+        const int cy = static_cast<int>(i) / chunks_x;
+        _dirty_rects[i] = Rect2I(
+            cx * ChunkMap::CHUNK_SIZE, cy * ChunkMap::CHUNK_SIZE,
+            cx * ChunkMap::CHUNK_SIZE + ChunkMap::CHUNK_SIZE - 1, cy * ChunkMap::CHUNK_SIZE + ChunkMap::CHUNK_SIZE - 1)
+            .intersected(Rect2I(0, 0, _width - 1, _height - 1));
     }
 }
 
@@ -135,14 +624,43 @@ int Simulation::flatten_coords(const Vector2I &pos) const
     return flatten_coords(pos.x, pos.y);
 }
 
-ElementType* Simulation::get_type_by_id(const std::string &id) const
+const ElementRegistry& Simulation::get_registry() const
 {
-    return _element_registry.get_type_by_id(id);
+    return *_element_registry;
+}
+
+const SharedElementRegistry& Simulation::get_shared_registry() const
+{
+    return _element_registry;
+}
+
+void Simulation::set_registry(SharedElementRegistry registry)
+{
+    const std::vector<ElementIndex> remap = _element_registry->get_remap_to(*registry);
+    _element_registry = std::move(registry);
+    _cells.set_registry(*_element_registry);
+    const int rows = _height + 2 * CellMatrix::PADDING;
+    if (_thread_pool) {
+        constexpr int BAND_ROWS = 64;
+        _thread_pool->parallel_for((rows + BAND_ROWS - 1) / BAND_ROWS, [&](const int band) {
+            const int begin = band * BAND_ROWS - CellMatrix::PADDING;
+            _cells.remap_rows(remap, begin, std::min(begin + BAND_ROWS, _height + CellMatrix::PADDING));
+        });
+    } else {
+        _cells.remap_rows(remap, -CellMatrix::PADDING, _height + CellMatrix::PADDING);
+    }
+    reset_movement_stats();
+    wake_all();
+}
+
+const ElementType* Simulation::get_type_by_id(const std::string &id) const
+{
+    return _element_registry->get_type_by_id(id);
 }
 
 std::vector<const ElementType *> Simulation::get_all_element_types() const
 {
-    return _element_registry.get_all_types();
+    return _element_registry->get_all_types();
 }
 
 bool Simulation::is_pos_empty(const Vector2I &pos) const
@@ -152,10 +670,9 @@ bool Simulation::is_pos_empty(const Vector2I &pos) const
 
 bool Simulation::is_pos_empty(const int x, const int y) const
 {
-    const auto cell_type = get_type_at(x, y);
-    if (cell_type == nullptr) // TODO: Surely there's a better way to represent this?
+    if (!is_pos_within_bounds(x, y))
         return false;
-    return get_type_at(x, y)->get_id() == "EMPTY";
+    return _cells.is_empty(x, y);
 }
 
 bool Simulation::is_pos_within_bounds(const Vector2I &pos) const
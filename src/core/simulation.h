@@ -6,16 +6,53 @@
 #define SIMULATION_H
 
 #include <raylib.h>
+#include <memory>
 #include <vector>
 
 #include "../types/vector2i.h"
 #include "../elements/element_registry.h"
 #include "cell_matrix.h"
+#include "heat_diffusion.h"
+#include "thread_pool.h"
+#include "../utils/movement_stats.h"
+
+class EditJournal;
+
+/**
+ * @brief How step() stages its writes.
+ *
+ * IN_PLACE updates the live grid directly; the generation write mask keeps a particle that
+ * already moved this tick from being stepped again. DOUBLE_BUFFERED copies the grid into a
+ * second buffer every tick and reads the previous tick's state while writing the new one.
+ * Particles can therefore see different neighbours under the two schemes, and their results
+ * may diverge by design: hashes only compare between runs of the same scheme. The reference for
+ * hash checks is BY_KIND in place on one thread (sandstone_bench --check-dispatch).
+ */
+enum class StepScheme {
+    IN_PLACE = 0,
+    DOUBLE_BUFFERED
+};
+
+/**
+ * @brief How step() reaches each particle's update.
+ *
+ * BY_KIND switches on the cell's ElementKind from the registry table and calls the kind's
+ * static update directly; EMPTY and immovable cells are skipped without a call. It is the
+ * reference the others are checked against. VIRTUAL goes through ElementType::step_particle_at
+ * for every cell. BITBOARD is BY_KIND, except that row spans of a single movable solid go
+ * through GranularEngine when stepping in place. sandstone_bench --check-dispatch verifies that
+ * all three give the same hashes on every bench scene.
+ */
+enum class StepDispatch {
+    BY_KIND = 0,
+    VIRTUAL,
+    BITBOARD
+};
 
 class Simulation {
 public:
-    Simulation(int width, int height, ElementRegistry& element_registry);
-    explicit Simulation(const Vector2I &size, ElementRegistry& element_registry);
+    Simulation(int width, int height, SharedElementRegistry element_registry);
+    Simulation(const Vector2I &size, SharedElementRegistry element_registry);
     ~Simulation() = default;
 
     const Vector2I UP = Vector2I(0, -1);
@@ -25,22 +62,125 @@ public:
 
     void step();
 
+    static constexpr int NEVER_SETTLE = -1;
+
+    /**
+     * @brief Run up to `ticks` ticks back to back, e.g. to pre-settle a generated world.
+     * @details The ticks are the same as step()'s, minus the dirty-rect bookkeeping the renderer
+     *          needs after each one; everything is marked dirty once at the end instead.
+     * @param settled_awake_chunks Stop after the first tick that scanned at most this many
+     *        chunks. 0 means nothing can move any more (heat may still be spreading); liquid
+     *        left on an uneven floor can shuffle forever, so a small tolerance is often needed.
+     * @return Number of ticks run.
+     */
+    int step_n(int ticks, int settled_awake_chunks = NEVER_SETTLE);
+
+    /**
+     * @brief Number of threads used by step().
+     * @details 1 (the default) steps the whole grid serially, row by row. Higher counts switch
+     *          to checkerboard stepping: awake chunks are updated in four 2x2 phases on a worker
+     *          pool, so chunks processed at the same time are never neighbours.
+     */
+    void set_thread_count(int count);
+    int get_thread_count() const;
+
+    void set_step_scheme(StepScheme scheme);
+    StepScheme get_step_scheme() const;
+
+    void set_step_dispatch(StepDispatch dispatch);
+    StepDispatch get_step_dispatch() const;
+
+    /**
+     * @brief Run heat conduction every `ticks` ticks (0 disables it).
+     * @details Each run is a single diffusion step, so longer intervals also slow heat down.
+     *          Bands of rows whose temperatures have settled and whose chunks sleep are skipped.
+     */
+    void set_heat_interval(int ticks);
+    int get_heat_interval() const;
+
+    /**
+     * @brief Make step() reseed the RNG from (seed, tick) at the start of every tick.
+     * @details Randomness used between ticks (brush colours, spray) then cannot shift the
+     *          simulation's random stream, which is what makes journal replays bit-exact.
+     */
+    void set_seed(uint32_t seed);
+    bool is_seeded() const;
+    uint32_t get_seed() const;
+    /**
+     * @brief Count, per element, cells stepped, moves, swaps and failed MovementUtils calls.
+     * @details Off by default. Each thread counts into its own table and the tables are merged
+     *          once per tick. Switching registries resets the counters.
+     */
+    void set_movement_stats_enabled(bool enabled);
+    bool is_movement_stats_enabled() const;
+    // Indexed by ElementIndex: the last tick's counters, and their sum since enabled or reset
+    const std::vector<MovementStats>& get_tick_movement_stats() const;
+    const std::vector<MovementStats>& get_total_movement_stats() const;
+    void reset_movement_stats();
+
+    // Every successful set_type_at() is recorded into `journal` (nullptr to stop)
+    void set_journal(EditJournal *journal);
+    int get_step_count() const;
+    // Used when restoring a saved world; also moves the per-tick reseed along
+    void set_step_count(int count);
+    // FNV-1a over the cell planes; equal hashes mean identical worlds
+    uint64_t get_state_hash() const;
+
     bool set_type_at(int x, int y, const ElementType *type, int color_idx = -1);
     bool set_type_at(const Vector2I &pos, const ElementType *type, int color_idx = -1);
     bool set_type_at(int x, int y, const std::string &id, int color_idx = -1);
     bool set_type_at(const Vector2I &pos,  const std::string &id, int color_idx = -1);
     const ElementType* get_type_at(int x, int y) const;
     const ElementType* get_type_at(const Vector2I &pos) const;
+
+    /**
+     * @brief Raw cell access for bulk copies such as WorldStore paging.
+     * @details set_cell() neither journals nor wakes anything; call wake_all() once done.
+     */
+    CellData get_cell(int x, int y) const;
+    void set_cell(int x, int y, const CellData &cell);
+    // Wake every chunk and mark the whole grid dirty
+    void wake_all();
+
     void fill_render_buffer(Color *dst) const;
+    // Paint only `rect` into dst, packed row by row (rect width pixels per row)
+    void fill_render_rect(Color *dst, const Rect2I &rect) const;
+    // Paint only `rect` into a full image with `dst_stride` pixels per row
+    void fill_render_rect(Color *dst, int dst_stride, const Rect2I &rect) const;
+    // Maps [t_min, t_max] onto a TEMPERATURE_LUT_SIZE-entry colormap from cold to hot
     void fill_temperature_buffer(Color *dst, Color cold, Color hot, int t_min = 0, int t_max = 1000) const;
+    static constexpr int TEMPERATURE_LUT_SIZE = 1024;
 
     int get_width() const;
     int get_height() const;
+    // Chunks scanned by the last step (see ChunkMap)
+    int get_awake_chunk_count() const;
+
+    /**
+     * @brief Regions whose cells changed since the last call, then forget them.
+     * @details Gathered per chunk from the wakes of moves and edits, so rects may overshoot
+     *          the changed cells by ChunkMap::WAKE_MARGIN. Adjacent chunks in a chunk row are
+     *          merged into one rect. Everything is dirty right after construction.
+     */
+    std::vector<Rect2I> take_dirty_rects();
+    void mark_all_dirty();
 
     int flatten_coords(int x, int y) const;
     int flatten_coords(const Vector2I &pos) const;
 
-    ElementType* get_type_by_id(const std::string &id) const;
+    const ElementRegistry& get_registry() const;
+    const SharedElementRegistry& get_shared_registry() const;
+
+    /**
+     * @brief Switch to another registry between ticks, e.g. one reloaded from edited XML.
+     * @details Cells are remapped by element id in one pass over the grid (split across the
+     *          thread pool when there is one); elements missing from `registry` become EMPTY.
+     *          The simulation drops its share of the old registry, which is freed once no other
+     *          simulation uses it. Cells keep their temperature; everything is woken. Movement
+     *          stats start over.
+     */
+    void set_registry(SharedElementRegistry registry);
+    const ElementType* get_type_by_id(const std::string &id) const;
     std::vector<const ElementType*> get_all_element_types() const;
     bool is_pos_empty(const Vector2I &pos) const;
     bool is_pos_empty(int x, int y) const;
@@ -48,14 +188,49 @@ public:
     bool is_pos_within_bounds(int x, int y) const;
 
 private:
-    ElementRegistry& _element_registry;
+    // One tick without the renderer's dirty-rect bookkeeping
+    void tick();
+    void step_serial(bool scan_left_to_right);
+    void step_checkerboard(bool scan_left_to_right);
+    void step_chunk(int cx, int cy, bool scan_left_to_right);
+    void step_span(int y, int min_x, int max_x, bool scan_left_to_right);
+    // GranularEngine::step_span plus its share of the movement stats and the profiler
+    bool step_granular_span(int y, int min_x, int max_x, bool scan_left_to_right);
+    void step_cell(int x, int y);
+    // Counts the cell for the movement stats and the profiler; times one cell in CELL_SAMPLE_RATE
+    void step_cell_instrumented(int x, int y);
+    void update_cell(int x, int y);
+    void collect_dirty_rects();
+    void merge_movement_stats();
+    // Paint `rect` with its top-left pixel at `origin` and `stride` pixels per row
+    void paint_rect(Color *origin, int stride, const Rect2I &rect) const;
+
+    SharedElementRegistry _element_registry;
     
     int _width;
     int _height;
     int _step_count = 0;
+    StepScheme _step_scheme = StepScheme::IN_PLACE;
+    StepDispatch _step_dispatch = StepDispatch::BITBOARD;
+    int _heat_interval = 1;
+    bool _seeded = false;
+    uint32_t _seed = 0;
+    EditJournal *_journal = nullptr;
+    bool _profiling = false; // Profiler::is_enabled() at the start of the current tick
+    bool _instrumented = false; // Profiling or gathering movement stats this tick
+    bool _movement_stats_enabled = false;
+    std::vector<std::vector<MovementStats>> _thread_movement_stats; // [worker][element]
+    std::vector<MovementStats> _tick_movement_stats;
+    std::vector<MovementStats> _total_movement_stats;
 
     CellMatrix _cells;
-    CellMatrix _next_cells;
+    CellMatrix _next_cells; // Only allocated by the DOUBLE_BUFFERED scheme
+    CellMatrix *_write_cells = &_cells; // Buffer written by the current tick
+
+    std::unique_ptr<ThreadPool> _thread_pool;
+    HeatDiffusion _heat;
+    std::vector<int> _phase_chunks;
+    std::vector<Rect2I> _dirty_rects; // Per chunk, changed since the last take_dirty_rects()
 };
 
 #endif //SIMULATION_H
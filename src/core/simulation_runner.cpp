@@ -0,0 +1,183 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "simulation_runner.h"
+#include "../utils/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+SimulationRunner::SimulationRunner(Simulation &sim, const int ticks_per_second)
+    : _sim(sim), _ticks_per_second(std::max(1, ticks_per_second)) { }
+
+SimulationRunner::~SimulationRunner()
+{
+    stop();
+}
+
+void SimulationRunner::start()
+{
+    if (_running.exchange(true))
+        return;
+    _thread = std::thread(&SimulationRunner::thread_main, this);
+}
+
+void SimulationRunner::stop()
+{
+    _running = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+bool SimulationRunner::is_running() const
+{
+    return _running;
+}
+
+void SimulationRunner::push_edits(const std::vector<EditCommand> &edits)
+{
+    if (edits.empty())
+        return;
+    std::lock_guard lock(_edits_mutex);
+    _pending_edits.insert(_pending_edits.end(), edits.begin(), edits.end());
+}
+
+void SimulationRunner::push_registry(SharedElementRegistry registry)
+{
+    std::lock_guard lock(_edits_mutex);
+    _pending_registries.emplace_back(_pending_edits.size(), std::move(registry));
+}
+
+void SimulationRunner::set_temperature_view(const bool enabled)
+{
+    _temperature_view.store(enabled, std::memory_order_relaxed);
+}
+
+void SimulationRunner::set_movement_stats(const bool enabled)
+{
+    _movement_stats.store(enabled, std::memory_order_relaxed);
+}
+
+const FrameSnapshot* SimulationRunner::acquire_snapshot()
+{
+    if (_middle.load(std::memory_order_acquire) & FRESH_BIT)
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX_MASK;
+    const FrameSnapshot &snapshot = _snapshots[_front];
+    return snapshot.sequence == 0 ? nullptr : &snapshot;
+}
+
+void SimulationRunner::thread_main()
+{
+    using Clock = std::chrono::steady_clock;
+    const auto tick = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / _ticks_per_second));
+
+    publish();
+    auto next_tick = Clock::now() + tick;
+    while (_running.load(std::memory_order_relaxed)) {
+        int ticks = 0;
+        while (ticks < MAX_CATCH_UP_TICKS && Clock::now() >= next_tick) {
+            apply_edits();
+            if (const bool stats = _movement_stats.load(std::memory_order_relaxed); stats != _sim.is_movement_stats_enabled())
+                _sim.set_movement_stats_enabled(stats);
+            _sim.step();
+            next_tick += tick;
+            ++ticks;
+        }
+        // Too far behind: drop the backlog instead of spiralling
+        if (Clock::now() >= next_tick)
+            next_tick = Clock::now() + tick;
+
+        if (ticks > 0)
+            publish();
+        std::this_thread::sleep_until(next_tick);
+    }
+    // Leave nothing queued, so whoever uses the simulation after stop() sees every edit and
+    // registry switch
+    apply_edits();
+}
+
+void SimulationRunner::apply_edits()
+{
+    {
+        std::lock_guard lock(_edits_mutex);
+        _applying_edits.swap(_pending_edits);
+        _applying_registries.swap(_pending_registries);
+    }
+    size_t next_swap = 0;
+    for (size_t i = 0; i <= _applying_edits.size(); ++i) {
+        // Switch registries exactly where they were queued; the old one is freed here
+        while (next_swap < _applying_registries.size() && _applying_registries[next_swap].first == i) {
+            _sim.set_registry(std::move(_applying_registries[next_swap].second));
+            ++next_swap;
+        }
+        if (i == _applying_edits.size())
+            break;
+        const EditCommand &edit = _applying_edits[i];
+        if (edit.only_if_empty && !_sim.is_pos_empty(edit.pos))
+            continue;
+        _sim.set_type_at(edit.pos, edit.type, edit.color_idx);
+    }
+    _applying_edits.clear();
+    _applying_registries.clear();
+}
+
+void SimulationRunner::publish()
+{
+    const bool temperature_view = _temperature_view.load(std::memory_order_relaxed);
+    const bool view_changed = temperature_view != _published_temperature_view || _sequence == 0;
+    std::vector<Rect2I> changed = _sim.take_dirty_rects();
+
+    // Every slot has to catch up on what changed, including the two the painter is not holding
+    for (size_t slot = 0; slot < _snapshots.size(); ++slot) {
+        if (temperature_view || view_changed || _stale_rects[slot].size() + changed.size() > MAX_STALE_RECTS) {
+            _stale_full[slot] = true;
+            _stale_rects[slot].clear();
+        } else if (!_stale_full[slot]) {
+            _stale_rects[slot].insert(_stale_rects[slot].end(), changed.begin(), changed.end());
+        }
+    }
+
+    FrameSnapshot &snapshot = _snapshots[_back];
+    const int width = _sim.get_width();
+    snapshot.pixels.resize(static_cast<size_t>(width) * _sim.get_height());
+    {
+        const ProfileScope fill_scope(ProfilePhase::RENDER_FILL);
+        if (temperature_view) {
+            constexpr Color COLD { 30, 17, 45, 255 };
+            constexpr Color HOT  { 244, 134, 93, 255 };
+            _sim.fill_temperature_buffer(snapshot.pixels.data(), COLD, HOT, 0, 1100);
+        } else if (_stale_full[_back]) {
+            _sim.fill_render_buffer(snapshot.pixels.data());
+        } else {
+            for (const Rect2I &rect : _stale_rects[_back]) {
+                _sim.fill_render_rect(snapshot.pixels.data(), width, rect);
+            }
+        }
+    }
+    _stale_rects[_back].clear();
+    _stale_full[_back] = false;
+
+    snapshot.dirty_rects = std::move(changed);
+    snapshot.full = temperature_view || view_changed;
+    snapshot.temperature_view = temperature_view;
+    snapshot.sequence = ++_sequence;
+    snapshot.step_count = _sim.get_step_count();
+    snapshot.movement_stats.clear();
+    if (_sim.is_movement_stats_enabled()) {
+        const std::vector<MovementStats> &stats = _sim.get_tick_movement_stats();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            if (stats[i].cells_stepped == 0)
+                continue;
+            const ElementType *type = _sim.get_registry().get_type_by_index(static_cast<ElementIndex>(i));
+            snapshot.movement_stats.push_back({ type->get_id(), stats[i] });
+        }
+        std::ranges::sort(snapshot.movement_stats, [](const auto &a, const auto &b) {
+            return a.stats.cells_stepped > b.stats.cells_stepped;
+        });
+    }
+    _published_temperature_view = temperature_view;
+
+    _back = _middle.exchange(_back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
@@ -0,0 +1,143 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_SIMULATION_RUNNER_H
+#define SANDSTONE_SIMULATION_RUNNER_H
+
+#include "simulation.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One cell edit queued for the simulation thread.
+ * @details `only_if_empty` is checked when the edit is applied, against the world as it is at
+ *          that tick boundary, not as it was when the brush was drawn.
+ */
+struct EditCommand {
+    Vector2I pos;
+    const ElementType *type = nullptr;
+    int color_idx = -1;
+    bool only_if_empty = false;
+};
+
+// One element's movement counters for the tick a snapshot shows
+struct ElementMovementReport {
+    std::string id;
+    MovementStats stats;
+};
+
+/**
+ * @brief Immutable picture of the world published by the simulation thread.
+ * @details `dirty_rects` lists what changed since the previous snapshot (sequence - 1). A reader
+ *          that skipped snapshots, or gets one marked `full`, has to take the whole image.
+ */
+struct FrameSnapshot {
+    std::vector<Color> pixels;
+    std::vector<Rect2I> dirty_rects;
+    bool full = true;
+    bool temperature_view = false;
+    uint64_t sequence = 0;
+    int step_count = 0;
+    // Elements stepped in the last tick, most stepped first; empty unless enabled on the runner
+    std::vector<ElementMovementReport> movement_stats;
+};
+
+/**
+ * @brief Steps a Simulation on its own thread at a fixed rate, independent of the display.
+ *
+ * Frames reach the render thread through a lock-free triple buffer: the simulation thread
+ * paints the back snapshot and swaps it with the middle one, the render thread swaps the middle
+ * one with its front snapshot whenever a newer one is waiting. Neither side ever blocks the
+ * other. Edits travel the other way through a command queue drained at tick boundaries.
+ *
+ * While running, the simulation belongs to the simulation thread; touch it again only after
+ * stop(). Queued registry switches hold their registry, and the simulation holds the one it
+ * uses, so the types a queued edit points at outlive the edit.
+ */
+class SimulationRunner {
+public:
+    static constexpr int DEFAULT_TICKS_PER_SECOND = 120;
+    // Ticks run back to back after a stall before the backlog is dropped
+    static constexpr int MAX_CATCH_UP_TICKS = 4;
+
+    explicit SimulationRunner(Simulation &sim, int ticks_per_second = DEFAULT_TICKS_PER_SECOND);
+    ~SimulationRunner();
+
+    SimulationRunner(const SimulationRunner&) = delete;
+    SimulationRunner& operator=(const SimulationRunner&) = delete;
+
+    void start();
+    // Joins the simulation thread after applying everything queued; safe to call more than once
+    void stop();
+    bool is_running() const;
+
+    // Queue edits for the start of the next tick
+    void push_edits(const std::vector<EditCommand> &edits);
+
+    /**
+     * @brief Queue a switch to `registry` (see Simulation::set_registry).
+     * @details Edits pushed before this call are applied with the old registry, later ones with
+     *          the new one, so the caller can move its brush over to `registry` right away.
+     */
+    void push_registry(SharedElementRegistry registry);
+
+    // Switch what the snapshots show; the next snapshot is then a full one
+    void set_temperature_view(bool enabled);
+    // Gather movement stats (see Simulation::set_movement_stats_enabled) into the snapshots
+    void set_movement_stats(bool enabled);
+
+    /**
+     * @brief Newest published snapshot, or nullptr before the first one.
+     * @details Only the render thread may call this. The snapshot stays valid and unchanged
+     *          until the next call.
+     */
+    const FrameSnapshot* acquire_snapshot();
+
+private:
+    // Slot index plus a flag telling the reader the middle slot holds an unread snapshot
+    static constexpr uint8_t FRESH_BIT = 0x4;
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    // Repaints queued for one slot before a full repaint is cheaper
+    static constexpr size_t MAX_STALE_RECTS = 64;
+
+    void thread_main();
+    void apply_edits();
+    void publish();
+
+    Simulation &_sim;
+    int _ticks_per_second;
+    std::thread _thread;
+    std::atomic<bool> _running = false;
+
+    // Registry switch and the number of queued edits that precede it
+    using RegistrySwap = std::pair<size_t, SharedElementRegistry>;
+
+    std::mutex _edits_mutex;
+    std::vector<EditCommand> _pending_edits;
+    std::vector<RegistrySwap> _pending_registries;
+    std::vector<EditCommand> _applying_edits;       // Simulation thread only
+    std::vector<RegistrySwap> _applying_registries; // Simulation thread only
+
+    std::atomic<bool> _temperature_view = false;
+    std::atomic<bool> _movement_stats = false;
+
+    std::array<FrameSnapshot, 3> _snapshots;
+    // Regions each slot still has to repaint, and whether it needs everything (simulation thread only)
+    std::array<std::vector<Rect2I>, 3> _stale_rects;
+    std::array<bool, 3> _stale_full = { true, true, true };
+    uint8_t _back = 0;                 // Simulation thread only
+    std::atomic<uint8_t> _middle = 1;
+    uint8_t _front = 2;                // Render thread only
+    uint64_t _sequence = 0;
+    bool _published_temperature_view = false;
+};
+
+#endif //SANDSTONE_SIMULATION_RUNNER_H
@@ -0,0 +1,99 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "thread_pool.h"
+
+// Pool and index of the worker running on this thread
+static thread_local const ThreadPool *t_pool = nullptr;
+static thread_local int t_worker_index = 0;
+
+ThreadPool::ThreadPool(const int thread_count)
+{
+    for (int i = 1; i < thread_count; ++i) {
+        _workers.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _work_cv.notify_all();
+    for (std::thread &worker : _workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::get_thread_count() const
+{
+    return static_cast<int>(_workers.size()) + 1;
+}
+
+void ThreadPool::parallel_for(const int count, const std::function<void(int)> &job)
+{
+    if (count <= 0)
+        return;
+
+    if (_workers.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        _job = &job;
+        _count = count;
+        _next_index.store(0, std::memory_order_relaxed);
+        _pending_workers = static_cast<int>(_workers.size());
+        ++_batch;
+    }
+    _work_cv.notify_all();
+
+    run_batch();
+
+    std::unique_lock lock(_mutex);
+    _done_cv.wait(lock, [this] { return _pending_workers == 0; });
+    _job = nullptr;
+}
+
+int ThreadPool::get_worker_index() const
+{
+    return t_pool == this ? t_worker_index : 0;
+}
+
+void ThreadPool::worker_loop(const int index)
+{
+    t_pool = this;
+    t_worker_index = index;
+    uint64_t seen_batch = 0;
+    while (true) {
+        {
+            std::unique_lock lock(_mutex);
+            _work_cv.wait(lock, [&] { return _stopping || _batch != seen_batch; });
+            if (_stopping)
+                return;
+            seen_batch = _batch;
+        }
+
+        run_batch();
+
+        {
+            std::lock_guard lock(_mutex);
+            if (--_pending_workers == 0)
+                _done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run_batch()
+{
+    int i;
+    while ((i = _next_index.fetch_add(1, std::memory_order_relaxed)) < _count) {
+        (*_job)(i);
+    }
+}
@@ -0,0 +1,57 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_THREAD_POOL_H
+#define SANDSTONE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads running fork/join batches.
+ *
+ * The calling thread takes part in every batch, so a pool of N threads spawns N - 1 workers.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int get_thread_count() const;
+    // 1..N-1 on this pool's workers, 0 on any other thread (including the caller)
+    int get_worker_index() const;
+
+    /**
+     * @brief Run job(i) for every i in [0, count) and block until all of them finished.
+     * @param count Number of work items.
+     * @param job Work item callback; must be safe to call concurrently for distinct indices.
+     */
+    void parallel_for(int count, const std::function<void(int)> &job);
+
+private:
+    void worker_loop(int index);
+    void run_batch();
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _done_cv;
+
+    const std::function<void(int)> *_job = nullptr;
+    int _count = 0;
+    std::atomic<int> _next_index { 0 };
+    int _pending_workers = 0;
+    uint64_t _batch = 0;
+    bool _stopping = false;
+};
+
+#endif //SANDSTONE_THREAD_POOL_H
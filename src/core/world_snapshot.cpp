@@ -0,0 +1,347 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "world_snapshot.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+static constexpr char SNAPSHOT_MAGIC[4] = { 'S', 'S', 'W', 'S' };
+// Version 2 stores temperatures as float bit patterns; version 1 files hold whole degrees
+static constexpr uint32_t SNAPSHOT_VERSION = 2;
+static constexpr uint32_t SNAPSHOT_VERSION_INT_TEMPS = 1;
+
+namespace {
+
+// Appends little-endian fixed-width fields and LEB128 varints to a byte buffer
+class ByteWriter {
+public:
+    std::vector<uint8_t> bytes;
+
+    template <typename T>
+    void put_le(const T value)
+    {
+        auto v = static_cast<std::make_unsigned_t<T>>(value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bytes.push_back(static_cast<uint8_t>(v & 0xFF));
+            v = static_cast<decltype(v)>(v >> 8);
+        }
+    }
+
+    void put_varint(uint64_t v)
+    {
+        while (v >= 0x80) {
+            bytes.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(v));
+    }
+
+    void put_string(const std::string &s)
+    {
+        put_le<uint16_t>(static_cast<uint16_t>(s.size()));
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+};
+
+// Bounds-checked reader over a loaded file; every getter returns false past the end
+class ByteReader {
+public:
+    ByteReader(const uint8_t *data, const size_t size) : _data(data), _size(size) { }
+
+    template <typename T>
+    bool get_le(T &value)
+    {
+        if (_size - _pos < sizeof(T))
+            return false;
+        std::make_unsigned_t<T> v = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            v |= static_cast<decltype(v)>(static_cast<decltype(v)>(_data[_pos++]) << (8 * i));
+        }
+        value = static_cast<T>(v);
+        return true;
+    }
+
+    bool get_varint(uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (_pos >= _size)
+                return false;
+            const uint8_t b = _data[_pos++];
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool get_string(std::string &s)
+    {
+        uint16_t len = 0;
+        if (!get_le(len) || _size - _pos < len)
+            return false;
+        s.assign(reinterpret_cast<const char*>(_data + _pos), len);
+        _pos += len;
+        return true;
+    }
+
+    bool get_bytes(char *out, const size_t count)
+    {
+        if (_size - _pos < count)
+            return false;
+        std::memcpy(out, _data + _pos, count);
+        _pos += count;
+        return true;
+    }
+
+private:
+    const uint8_t *_data;
+    size_t _size;
+    size_t _pos = 0;
+};
+
+uint64_t zigzag(const int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(const uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// One plane of a chunk as (run length, value) pairs
+void put_runs(ByteWriter &out, const std::vector<uint64_t> &values)
+{
+    size_t i = 0;
+    while (i < values.size()) {
+        size_t run = 1;
+        while (i + run < values.size() && values[i + run] == values[i]) {
+            ++run;
+        }
+        out.put_varint(run);
+        out.put_varint(values[i]);
+        i += run;
+    }
+}
+
+bool get_runs(ByteReader &in, std::vector<uint64_t> &values, const size_t count)
+{
+    values.clear();
+    while (values.size() < count) {
+        uint64_t run = 0, value = 0;
+        if (!in.get_varint(run) || !in.get_varint(value) || run == 0 || run > count - values.size())
+            return false;
+        values.insert(values.end(), run, value);
+    }
+    return true;
+}
+
+// Cells of every chunk in row-major chunk order, each clipped to the grid
+template <typename Visit>
+void for_each_chunk(const int width, const int height, const Visit &visit)
+{
+    constexpr int CS = ChunkMap::CHUNK_SIZE;
+    for (int cy = 0; cy * CS < height; ++cy) {
+        for (int cx = 0; cx * CS < width; ++cx) {
+            visit(Rect2I(cx * CS, cy * CS, std::min(width, (cx + 1) * CS) - 1, std::min(height, (cy + 1) * CS) - 1));
+        }
+    }
+}
+
+}
+
+bool WorldSnapshot::save(const Simulation &sim, const std::string &path)
+{
+    const ElementRegistry &registry = sim.get_registry();
+    ByteWriter out;
+    out.bytes.insert(out.bytes.end(), std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC));
+    out.put_le<uint32_t>(SNAPSHOT_VERSION);
+    out.put_le<int32_t>(sim.get_width());
+    out.put_le<int32_t>(sim.get_height());
+    out.put_le<uint32_t>(static_cast<uint32_t>(sim.get_step_count()));
+    out.put_le<uint8_t>(sim.is_seeded() ? 1 : 0);
+    out.put_le<uint32_t>(sim.get_seed());
+    out.put_le<int32_t>(ChunkMap::CHUNK_SIZE);
+
+    const auto &types = registry.get_types_by_index();
+    out.put_le<uint16_t>(static_cast<uint16_t>(types.size()));
+    for (const ElementType *type : types) {
+        out.put_string(type->get_id());
+    }
+
+    std::vector<int> palette_slot(types.size(), -1);
+    std::vector<ElementIndex> palette;
+    std::vector<uint64_t> plane;
+    std::vector<CellData> cells;
+    for_each_chunk(sim.get_width(), sim.get_height(), [&](const Rect2I &chunk) {
+        cells.clear();
+        for (int y = chunk.min_y; y <= chunk.max_y; ++y) {
+            for (int x = chunk.min_x; x <= chunk.max_x; ++x) {
+                cells.push_back(sim.get_cell(x, y));
+            }
+        }
+
+        palette.clear();
+        for (const CellData &cell : cells) {
+            if (palette_slot[cell.type] < 0) {
+                palette_slot[cell.type] = static_cast<int>(palette.size());
+                palette.push_back(cell.type);
+            }
+        }
+        out.put_varint(palette.size());
+        for (const ElementIndex type : palette) {
+            out.put_varint(type);
+        }
+
+        const auto put_plane = [&](const auto &value_of) {
+            plane.clear();
+            for (const CellData &cell : cells) {
+                plane.push_back(value_of(cell));
+            }
+            put_runs(out, plane);
+        };
+        put_plane([&](const CellData &c) { return static_cast<uint64_t>(palette_slot[c.type]); });
+        put_plane([](const CellData &c) { return static_cast<uint64_t>(c.color_variant_index); });
+        put_plane([](const CellData &c) { return zigzag(c.vel_x); });
+        put_plane([](const CellData &c) { return zigzag(c.vel_y); });
+        put_plane([](const CellData &c) { return static_cast<uint64_t>(std::bit_cast<uint32_t>(c.temp_c)); });
+
+        for (const ElementIndex type : palette) {
+            palette_slot[type] = -1;
+        }
+    });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(out.bytes.data()), static_cast<std::streamsize>(out.bytes.size()));
+    return static_cast<bool>(file);
+}
+
+bool WorldSnapshot::read_size(const std::string &path, Vector2I &size)
+{
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[16];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+        return false;
+    ByteReader in(header, sizeof(header));
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t width = 0, height = 0;
+    if (!in.get_bytes(magic, sizeof(magic)) || !std::equal(magic, magic + 4, SNAPSHOT_MAGIC))
+        return false;
+    if (!in.get_le(version) || (version != SNAPSHOT_VERSION && version != SNAPSHOT_VERSION_INT_TEMPS)
+        || !in.get_le(width) || !in.get_le(height))
+        return false;
+    if (width <= 0 || height <= 0)
+        return false;
+    size = Vector2I(width, height);
+    return true;
+}
+
+bool WorldSnapshot::load(Simulation &sim, const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    ByteReader in(bytes.data(), bytes.size());
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!in.get_bytes(magic, sizeof(magic)) || !std::equal(magic, magic + 4, SNAPSHOT_MAGIC))
+        return false;
+    if (!in.get_le(version) || (version != SNAPSHOT_VERSION && version != SNAPSHOT_VERSION_INT_TEMPS))
+        return false;
+
+    int32_t width = 0, height = 0, chunk_size = 0;
+    uint32_t step_count = 0, seed = 0;
+    uint8_t seeded = 0;
+    if (!in.get_le(width) || !in.get_le(height) || !in.get_le(step_count)
+        || !in.get_le(seeded) || !in.get_le(seed) || !in.get_le(chunk_size))
+        return false;
+    if (width != sim.get_width() || height != sim.get_height() || chunk_size != ChunkMap::CHUNK_SIZE)
+        return false;
+
+    // File id table -> this registry's indices
+    const ElementRegistry &registry = sim.get_registry();
+    uint16_t id_count = 0;
+    if (!in.get_le(id_count))
+        return false;
+    std::vector<ElementIndex> index_of(id_count);
+    for (uint16_t i = 0; i < id_count; ++i) {
+        std::string id;
+        if (!in.get_string(id))
+            return false;
+        const ElementType *type = registry.get_type_by_id(id);
+        if (type == nullptr)
+            return false;
+        index_of[i] = type->get_index();
+    }
+
+    // Decode everything before touching the simulation, so a bad file leaves it intact
+    std::vector<CellData> world(static_cast<size_t>(width) * height);
+    std::vector<ElementIndex> palette;
+    std::vector<uint64_t> types, variants, vel_x, vel_y, temps;
+    bool ok = true;
+    for_each_chunk(width, height, [&](const Rect2I &chunk) {
+        if (!ok)
+            return;
+        const size_t count = static_cast<size_t>(chunk.get_width()) * chunk.get_height();
+        uint64_t palette_size = 0;
+        if (!in.get_varint(palette_size) || palette_size == 0 || palette_size > count) {
+            ok = false;
+            return;
+        }
+        palette.resize(palette_size);
+        for (ElementIndex &entry : palette) {
+            uint64_t id = 0;
+            if (!in.get_varint(id) || id >= index_of.size()) {
+                ok = false;
+                return;
+            }
+            entry = index_of[id];
+        }
+        if (!get_runs(in, types, count) || !get_runs(in, variants, count) || !get_runs(in, vel_x, count)
+            || !get_runs(in, vel_y, count) || !get_runs(in, temps, count)) {
+            ok = false;
+            return;
+        }
+
+        size_t i = 0;
+        for (int y = chunk.min_y; y <= chunk.max_y; ++y) {
+            CellData *row = world.data() + static_cast<size_t>(y) * width;
+            for (int x = chunk.min_x; x <= chunk.max_x; ++x, ++i) {
+                if (types[i] >= palette.size()) {
+                    ok = false;
+                    return;
+                }
+                const ElementType *type = registry.get_type_by_index(palette[types[i]]);
+                row[x] = {
+                    palette[types[i]],
+                    static_cast<uint8_t>(std::min<uint64_t>(variants[i], std::max<size_t>(1, type->get_color_variants().size()) - 1)),
+                    static_cast<int8_t>(unzigzag(vel_x[i])),
+                    static_cast<int8_t>(unzigzag(vel_y[i])),
+                    version == SNAPSHOT_VERSION_INT_TEMPS
+                        ? static_cast<float>(unzigzag(temps[i]))
+                        : std::bit_cast<float>(static_cast<uint32_t>(temps[i]))
+                };
+            }
+        }
+    });
+    if (!ok)
+        return false;
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            sim.set_cell(x, y, world[static_cast<size_t>(y) * width + x]);
+        }
+    }
+    sim.wake_all();
+    sim.set_step_count(static_cast<int>(step_count));
+    if (seeded)
+        sim.set_seed(seed);
+    return true;
+}
@@ -0,0 +1,40 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_WORLD_SNAPSHOT_H
+#define SANDSTONE_WORLD_SNAPSHOT_H
+
+#include <string>
+
+#include "../types/vector2i.h"
+
+class Simulation;
+
+/**
+ * @brief Versioned binary save file holding a Simulation's full state.
+ *
+ * Cells are written chunk by chunk (ChunkMap::CHUNK_SIZE squares). Each chunk lists the
+ * elements it uses in a small palette, then stores its type, colour, velocity and temperature
+ * planes as separate run-length streams of varints, so uniform areas cost a few bytes. Element
+ * types go through the file's own id table, like EditJournal, and survive registry renumbering.
+ *
+ * The tick count and seed are restored too. Chunk sleep state is not saved: a loaded world
+ * starts fully awake.
+ */
+class WorldSnapshot {
+public:
+    static bool save(const Simulation &sim, const std::string &path);
+
+    /**
+     * @brief Replace `sim`'s world with the one saved at `path`.
+     * @return false if the file is unreadable, malformed, sized differently from `sim` or uses
+     *         elements missing from its registry; `sim` is left untouched then.
+     */
+    static bool load(Simulation &sim, const std::string &path);
+
+    // World size stored at `path`, read from the header alone, to build a matching Simulation
+    static bool read_size(const std::string &path, Vector2I &size);
+};
+
+#endif //SANDSTONE_WORLD_SNAPSHOT_H
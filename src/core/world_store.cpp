@@ -0,0 +1,314 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "world_store.h"
+#include "simulation.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <stdlib.h>
+#else
+#include <random>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Tile coordinate of a cell coordinate, rounding towards negative infinity
+static int tile_of(const int v)
+{
+    return v >= 0 ? v / WorldStore::TILE_SIZE : -((-v + WorldStore::TILE_SIZE - 1) / WorldStore::TILE_SIZE);
+}
+
+// New empty directory under `root` that no other process uses; empty path on failure
+static std::filesystem::path make_unique_dir(const std::filesystem::path &root)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(root, ec);
+#if defined(__unix__) || defined(__APPLE__)
+    std::string pattern = (root / "sandstone_tiles-XXXXXX").string();
+    if (mkdtemp(pattern.data()) == nullptr)
+        return {};
+    return pattern;
+#else
+    // create_directory() only succeeds for the caller that actually made the directory
+    std::random_device random;
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        std::filesystem::path dir = root / ("sandstone_tiles-" + std::to_string(random()));
+        if (std::filesystem::create_directory(dir, ec))
+            return dir;
+    }
+    return {};
+#endif
+}
+
+WorldStore::WorldStore(std::filesystem::path cache_root)
+    : _cache_root(std::move(cache_root)) { }
+
+WorldStore::~WorldStore()
+{
+    if (_cache_dir.empty())
+        return;
+    std::error_code ec;
+    for (const auto &[key, remaps] : _cached) {
+        std::filesystem::remove(tile_path(key), ec);
+    }
+    std::filesystem::remove(_cache_dir, ec);
+}
+
+CellData WorldStore::Tile::get(const int i) const
+{
+    return { types[i], color_variants[i], vel_x[i], vel_y[i], temps[i] };
+}
+
+void WorldStore::Tile::set(const int i, const CellData &cell)
+{
+    types[i] = cell.type;
+    color_variants[i] = cell.color_variant_index;
+    vel_x[i] = cell.vel_x;
+    vel_y[i] = cell.vel_y;
+    temps[i] = cell.temp_c;
+}
+
+bool WorldStore::Tile::is_empty() const
+{
+    return std::ranges::all_of(types, [](const ElementIndex t) { return t == ElementRegistry::EMPTY_INDEX; });
+}
+
+uint64_t WorldStore::tile_key(const int tx, const int ty)
+{
+    return static_cast<uint64_t>(static_cast<uint32_t>(tx)) << 32 | static_cast<uint32_t>(ty);
+}
+
+std::filesystem::path WorldStore::tile_path(const uint64_t key) const
+{
+    const auto tx = static_cast<int32_t>(key >> 32);
+    const auto ty = static_cast<int32_t>(key & 0xFFFFFFFFu);
+    return _cache_dir / (std::to_string(tx) + "_" + std::to_string(ty) + ".tile");
+}
+
+WorldStore::Tile* WorldStore::find_tile(const int tx, const int ty)
+{
+    const uint64_t key = tile_key(tx, ty);
+    if (const auto it = _resident.find(key); it != _resident.end()) {
+        it->second->last_used = ++_clock;
+        return it->second.get();
+    }
+    const auto cached = _cached.find(key);
+    if (cached == _cached.end())
+        return nullptr;
+
+    auto tile = std::make_unique<Tile>();
+    if (!read_tile(key, *tile))
+        return nullptr;
+    // Catch up on the registry switches made while it was on disk
+    for (size_t r = cached->second; r < _remaps.size(); ++r) {
+        apply_remap(*tile, _remaps[r]);
+    }
+    std::error_code ec;
+    std::filesystem::remove(tile_path(key), ec);
+    _cached.erase(cached);
+    if (_cached.empty())
+        _remaps.clear();
+    if (tile->is_empty())
+        return nullptr;
+    tile->last_used = ++_clock;
+    return _resident.emplace(key, std::move(tile)).first->second.get();
+}
+
+WorldStore::Tile* WorldStore::create_tile(const int tx, const int ty)
+{
+    if (Tile *tile = find_tile(tx, ty))
+        return tile;
+    if (is_unreadable(tx, ty))
+        return nullptr;
+    auto tile = std::make_unique<Tile>();
+    for (int i = 0; i < TILE_CELLS; ++i) {
+        tile->set(i, CellData {});
+    }
+    tile->last_used = ++_clock;
+    return _resident.emplace(tile_key(tx, ty), std::move(tile)).first->second.get();
+}
+
+bool WorldStore::is_unreadable(const int tx, const int ty) const
+{
+    return _cached.contains(tile_key(tx, ty));
+}
+
+void WorldStore::drop_tile(const int tx, const int ty)
+{
+    _resident.erase(tile_key(tx, ty));
+}
+
+CellData WorldStore::get(const int x, const int y)
+{
+    const int tx = tile_of(x), ty = tile_of(y);
+    const Tile *tile = find_tile(tx, ty);
+    if (tile == nullptr)
+        return {};
+    return tile->get((y - ty * TILE_SIZE) * TILE_SIZE + (x - tx * TILE_SIZE));
+}
+
+bool WorldStore::set(const int x, const int y, const CellData &cell)
+{
+    const int tx = tile_of(x), ty = tile_of(y);
+    if (cell.type == ElementRegistry::EMPTY_INDEX && find_tile(tx, ty) == nullptr)
+        return !is_unreadable(tx, ty);
+    Tile *tile = create_tile(tx, ty);
+    if (tile == nullptr)
+        return false;
+    tile->set((y - ty * TILE_SIZE) * TILE_SIZE + (x - tx * TILE_SIZE), cell);
+    if (cell.type == ElementRegistry::EMPTY_INDEX && tile->is_empty())
+        drop_tile(tx, ty);
+    return true;
+}
+
+bool WorldStore::store_window(const Simulation &sim, const Vector2I &origin)
+{
+    bool ok = true;
+    const int w = sim.get_width(), h = sim.get_height();
+    for (int ty = tile_of(origin.y); ty <= tile_of(origin.y + h - 1); ++ty) {
+        for (int tx = tile_of(origin.x); tx <= tile_of(origin.x + w - 1); ++tx) {
+            // Part of the window covered by this tile, in world coordinates
+            const int min_x = std::max(origin.x, tx * TILE_SIZE);
+            const int max_x = std::min(origin.x + w, (tx + 1) * TILE_SIZE);
+            const int min_y = std::max(origin.y, ty * TILE_SIZE);
+            const int max_y = std::min(origin.y + h, (ty + 1) * TILE_SIZE);
+
+            Tile *tile = find_tile(tx, ty);
+            if (tile == nullptr && is_unreadable(tx, ty)) {
+                ok = false;
+                continue;
+            }
+            if (tile == nullptr) {
+                bool any = false;
+                for (int y = min_y; y < max_y && !any; ++y) {
+                    for (int x = min_x; x < max_x && !any; ++x) {
+                        any = !sim.is_pos_empty(x - origin.x, y - origin.y);
+                    }
+                }
+                if (!any)
+                    continue;
+                tile = create_tile(tx, ty);
+            }
+            for (int y = min_y; y < max_y; ++y) {
+                for (int x = min_x; x < max_x; ++x) {
+                    tile->set((y - ty * TILE_SIZE) * TILE_SIZE + (x - tx * TILE_SIZE), sim.get_cell(x - origin.x, y - origin.y));
+                }
+            }
+            if (tile->is_empty())
+                drop_tile(tx, ty);
+        }
+    }
+    return ok;
+}
+
+bool WorldStore::load_window(Simulation &sim, const Vector2I &origin)
+{
+    bool ok = true;
+    const int w = sim.get_width(), h = sim.get_height();
+    for (int ty = tile_of(origin.y); ty <= tile_of(origin.y + h - 1); ++ty) {
+        for (int tx = tile_of(origin.x); tx <= tile_of(origin.x + w - 1); ++tx) {
+            const int min_x = std::max(origin.x, tx * TILE_SIZE);
+            const int max_x = std::min(origin.x + w, (tx + 1) * TILE_SIZE);
+            const int min_y = std::max(origin.y, ty * TILE_SIZE);
+            const int max_y = std::min(origin.y + h, (ty + 1) * TILE_SIZE);
+
+            const Tile *tile = find_tile(tx, ty);
+            if (tile == nullptr && is_unreadable(tx, ty))
+                ok = false;
+            for (int y = min_y; y < max_y; ++y) {
+                for (int x = min_x; x < max_x; ++x) {
+                    const CellData cell = tile ? tile->get((y - ty * TILE_SIZE) * TILE_SIZE + (x - tx * TILE_SIZE)) : CellData {};
+                    sim.set_cell(x - origin.x, y - origin.y, cell);
+                }
+            }
+        }
+    }
+    sim.wake_all();
+    return ok;
+}
+
+void WorldStore::remap_types(const std::vector<ElementIndex> &remap, const ElementRegistry &registry)
+{
+    // Counts are copied: the registry may be gone by the time a cached tile comes back
+    Remap step { remap, std::vector<int>(registry.get_type_count() + 1) };
+    for (size_t i = 0; i < step.color_counts.size(); ++i) {
+        step.color_counts[i] = registry.get_color_count(static_cast<ElementIndex>(i));
+    }
+    // Tiles whose every element was removed end up empty and are dropped
+    for (auto it = _resident.begin(); it != _resident.end();) {
+        apply_remap(*it->second, step);
+        it = it->second->is_empty() ? _resident.erase(it) : std::next(it);
+    }
+    if (!_cached.empty())
+        _remaps.push_back(std::move(step));
+}
+
+void WorldStore::apply_remap(Tile &tile, const Remap &remap)
+{
+    for (int i = 0; i < TILE_CELLS; ++i) {
+        const ElementIndex type = remap.types[tile.types[i]];
+        tile.types[i] = type;
+        // The new definition may have fewer colours
+        tile.color_variants[i] = static_cast<uint8_t>(std::min<int>(tile.color_variants[i], remap.color_counts[type] - 1));
+    }
+}
+
+size_t WorldStore::evict(const size_t max_resident)
+{
+    if (_resident.size() <= max_resident)
+        return 0;
+
+    std::vector<std::pair<uint64_t, uint64_t>> by_age; // (last_used, key)
+    by_age.reserve(_resident.size());
+    for (const auto &[key, tile] : _resident) {
+        by_age.emplace_back(tile->last_used, key);
+    }
+    std::ranges::sort(by_age);
+
+    if (_cache_dir.empty())
+        _cache_dir = make_unique_dir(_cache_root);
+    if (_cache_dir.empty())
+        return 0;
+
+    size_t evicted = 0;
+    for (const auto &[last_used, key] : by_age) {
+        if (_resident.size() <= max_resident)
+            break;
+        if (!write_tile(key, *_resident.at(key)))
+            continue;
+        _resident.erase(key);
+        _cached[key] = _remaps.size();
+        ++evicted;
+    }
+    return evicted;
+}
+
+bool WorldStore::write_tile(const uint64_t key, const Tile &tile) const
+{
+    std::ofstream out(tile_path(key), std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char*>(tile.types.data()), sizeof(tile.types));
+    out.write(reinterpret_cast<const char*>(tile.color_variants.data()), sizeof(tile.color_variants));
+    out.write(reinterpret_cast<const char*>(tile.vel_x.data()), sizeof(tile.vel_x));
+    out.write(reinterpret_cast<const char*>(tile.vel_y.data()), sizeof(tile.vel_y));
+    out.write(reinterpret_cast<const char*>(tile.temps.data()), sizeof(tile.temps));
+    return static_cast<bool>(out);
+}
+
+bool WorldStore::read_tile(const uint64_t key, Tile &tile) const
+{
+    std::ifstream in(tile_path(key), std::ios::binary);
+    if (!in)
+        return false;
+    in.read(reinterpret_cast<char*>(tile.types.data()), sizeof(tile.types));
+    in.read(reinterpret_cast<char*>(tile.color_variants.data()), sizeof(tile.color_variants));
+    in.read(reinterpret_cast<char*>(tile.vel_x.data()), sizeof(tile.vel_x));
+    in.read(reinterpret_cast<char*>(tile.vel_y.data()), sizeof(tile.vel_y));
+    in.read(reinterpret_cast<char*>(tile.temps.data()), sizeof(tile.temps));
+    return static_cast<bool>(in);
+}
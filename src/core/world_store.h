@@ -0,0 +1,128 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_WORLD_STORE_H
+#define SANDSTONE_WORLD_STORE_H
+
+#include "cell_data.h"
+#include "chunk_map.h"
+#include "../types/vector2i.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ElementRegistry;
+class Simulation;
+
+/**
+ * @brief Unbounded world kept as sparse square tiles, of which a Simulation steps one window.
+ *
+ * Tiles are allocated the first time a non-empty cell is stored in them and dropped again once
+ * they hold nothing but empty cells, so untouched areas cost no memory; empty cells read back
+ * at the default CellData temperature. Cold tiles can be evicted to an on-disk cache and are
+ * paged back in transparently the next time they are read or written.
+ *
+ * The cache stores raw ElementIndex values in native byte order: it is only meant for the
+ * registry and machine that wrote it. Each store caches into a fresh directory of its own under
+ * the given root, created on the first eviction and deleted with the store.
+ *
+ * A cached tile that cannot be read back is never replaced: writes to it are refused and the
+ * calls that touched it report failure, so the data on disk is not silently overwritten.
+ */
+class WorldStore {
+public:
+    static constexpr int TILE_SIZE = ChunkMap::CHUNK_SIZE;
+
+    explicit WorldStore(std::filesystem::path cache_root);
+    ~WorldStore();
+
+    WorldStore(const WorldStore&) = delete;
+    WorldStore& operator=(const WorldStore&) = delete;
+
+    // Cells of unreadable tiles read as empty
+    CellData get(int x, int y);
+    // false, with nothing written, if the cell's tile is cached but could not be read back
+    bool set(int x, int y, const CellData &cell);
+
+    /**
+     * @brief Copy the simulation's whole grid into the world with its top-left cell at `origin`.
+     * @return false if some tiles could not be read back; their part of the window is not stored.
+     */
+    bool store_window(const Simulation &sim, const Vector2I &origin);
+    /**
+     * @brief Replace the simulation's whole grid with the world area at `origin`, waking everything.
+     * @return false if some tiles could not be read back; their cells are loaded empty.
+     */
+    bool load_window(Simulation &sim, const Vector2I &origin);
+
+    /**
+     * @brief Rewrite every tile's element indices through `remap` after a switch to `registry`.
+     * @details Colour variants are clamped to the new elements' colour counts, as in
+     *          CellMatrix::remap_rows. Resident tiles are rewritten now; cached ones stay on disk
+     *          and go through every remap issued since their eviction when they are paged back in.
+     */
+    void remap_types(const std::vector<ElementIndex> &remap, const ElementRegistry &registry);
+
+    /**
+     * @brief Write least recently used tiles to the cache until at most `max_resident` remain.
+     * @return Number of tiles evicted. Tiles that fail to write stay resident.
+     */
+    size_t evict(size_t max_resident);
+
+    size_t get_resident_tile_count() const { return _resident.size(); }
+    size_t get_cached_tile_count() const { return _cached.size(); }
+    // Empty until the first eviction
+    const std::filesystem::path& get_cache_dir() const { return _cache_dir; }
+
+private:
+    static constexpr int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+
+    struct Tile {
+        std::array<ElementIndex, TILE_CELLS> types;
+        std::array<uint8_t, TILE_CELLS> color_variants;
+        std::array<int8_t, TILE_CELLS> vel_x;
+        std::array<int8_t, TILE_CELLS> vel_y;
+        std::array<float, TILE_CELLS> temps;
+        uint64_t last_used = 0;
+
+        CellData get(int i) const;
+        void set(int i, const CellData &cell);
+        bool is_empty() const;
+    };
+
+    // One remap_types() call, kept for the tiles still on disk
+    struct Remap {
+        std::vector<ElementIndex> types;
+        std::vector<int> color_counts; // Of the target registry, by new index
+    };
+
+    static void apply_remap(Tile &tile, const Remap &remap);
+    static uint64_t tile_key(int tx, int ty);
+    std::filesystem::path tile_path(uint64_t key) const;
+
+    // Resident tile at (tx, ty), paged in from the cache if needed; nullptr if it holds nothing
+    // or could not be read back
+    Tile* find_tile(int tx, int ty);
+    // nullptr if the tile is cached but could not be read back
+    Tile* create_tile(int tx, int ty);
+    // After find_tile() returned nullptr: whether that was a failed read rather than no tile
+    bool is_unreadable(int tx, int ty) const;
+    void drop_tile(int tx, int ty);
+    bool write_tile(uint64_t key, const Tile &tile) const;
+    bool read_tile(uint64_t key, Tile &tile) const;
+
+    std::filesystem::path _cache_root;
+    std::filesystem::path _cache_dir;
+    std::unordered_map<uint64_t, std::unique_ptr<Tile>> _resident;
+    // Evicted tiles, so absent ones never touch the disk, each with the count of remaps it has had
+    std::unordered_map<uint64_t, size_t> _cached;
+    std::vector<Remap> _remaps; // Every remap_types() so far, in order
+    uint64_t _clock = 0;
+};
+
+#endif //SANDSTONE_WORLD_STORE_H
@@ -3,6 +3,7 @@
 //
 
 #include "element_loader.h"
+#include "element_pack.h"
 #include <vector>
 #include <string>
 #include <pugixml.hpp>
@@ -13,13 +14,26 @@
 #include "types/gas.h"
 #include "empty.h"
 
-static ElementType* create_by_kind(const std::string &kind)
+static ElementKind kind_from_string(const std::string &kind)
 {
-    if (kind == "Empty") return new Empty();
-    if (kind == "Liquid") return new Liquid();
-    if (kind == "MovableSolid") return new MovableSolid();
-    if (kind == "ImmovableSolid") return new ImmovableSolid();
-    if (kind == "Gas") return new Gas();
+    if (kind == "Empty") return ElementKind::Empty;
+    if (kind == "Liquid") return ElementKind::Liquid;
+    if (kind == "MovableSolid") return ElementKind::MovableSolid;
+    if (kind == "ImmovableSolid") return ElementKind::ImmovableSolid;
+    if (kind == "Gas") return ElementKind::Gas;
+    return ElementKind::Unknown;
+}
+
+ElementType* ElementLoader::create_by_kind(const ElementKind kind)
+{
+    switch (kind) {
+        case ElementKind::Empty: return new Empty();
+        case ElementKind::Liquid: return new Liquid();
+        case ElementKind::MovableSolid: return new MovableSolid();
+        case ElementKind::ImmovableSolid: return new ImmovableSolid();
+        case ElementKind::Gas: return new Gas();
+        case ElementKind::Unknown: break;
+    }
     return nullptr;
 }
 
@@ -43,16 +57,22 @@ ElementType* ElementLoader::_load_specific(const std::string &file) {
     const char* name_c = n.attribute("name").as_string(nullptr);
     const char* kind_c = n.attribute("kind").as_string(nullptr);
     const int density  = n.attribute("density").as_int(0);
+    const float conductivity  = n.attribute("conductivity").as_float(0.0f);
+    const float heat_capacity = n.attribute("heat_capacity").as_float(1.0f);
+    const int temperature     = n.attribute("temperature").as_int(25);
     if (!id_c || !name_c || !kind_c) return nullptr;
 
-    ElementType* t = create_by_kind(kind_c);
+    ElementType* t = create_by_kind(kind_from_string(kind_c));
     if (!t) return nullptr;
 
     const char* desc_c = n.child("Description").text().as_string("");
     t->set_id(id_c)
      ->set_name(name_c)
      ->set_description(desc_c)
-     ->set_density(density);
+     ->set_density(density)
+     ->set_conductivity(conductivity)
+     ->set_heat_capacity(heat_capacity)
+     ->set_temperature(temperature);
 
     for (const pugi::xml_node c : n.children("Color")) {
         Color col {
@@ -69,12 +89,18 @@ ElementType* ElementLoader::_load_specific(const std::string &file) {
 
 std::vector<ElementType*> ElementLoader::load_all() {
     std::vector<ElementType*> out;
+    _failed_files.clear();
 
     std::error_code ec;
     const std::filesystem::path dir(_directory_path);
     if (!std::filesystem::exists(dir, ec)) return out;
     if (!std::filesystem::is_directory(dir, ec)) return out;
 
+    const uint64_t fingerprint = ElementPack::fingerprint(_directory_path);
+    const std::string pack_path = (dir / ElementPack::FILE_NAME).string();
+    if (ElementPack::read(pack_path, fingerprint, out))
+        return out;
+
     for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
         if (ec) break;
         if (!entry.is_regular_file()) continue;
@@ -83,8 +109,13 @@ std::vector<ElementType*> ElementLoader::load_all() {
 
         if (ElementType* t = _load_specific(path.string())) {
             out.push_back(t);
+        } else {
+            _failed_files.push_back(path.string());
         }
     }
 
+    // A file caught half-written must be parsed again next time, not served from the pack
+    if (_failed_files.empty())
+        ElementPack::write(pack_path, out, fingerprint);
     return out;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #define ELEMENT_LOADER_H
 
 #include <string>
+#include <vector>
 
 #include "element_type.h"
 #include "../core/abstract/base_loader.h"
@@ -13,10 +14,27 @@
 class ElementLoader final : public BaseLoader<ElementType> {
 public:
     explicit ElementLoader(const std::string &path) : BaseLoader(path) {}
+
+    /**
+     * @brief Load every element in the directory.
+     * @details Reads the compiled ElementPack when it matches the XML sources; otherwise parses
+     *          the XML and rewrites the pack (best effort, a read-only directory just parses).
+     *          Files that fail to parse are skipped and listed in get_failed_files(); the pack
+     *          is not rewritten then.
+     */
     std::vector<ElementType*> load_all() override;
 
+    // XML files the last load_all() could not turn into an element
+    const std::vector<std::string>& get_failed_files() const { return _failed_files; }
+
+    // New, unconfigured type of the given kind; nullptr for Unknown
+    static ElementType* create_by_kind(ElementKind kind);
+
 protected:
     ElementType* _load_specific(const std::string &file) override;
+
+private:
+    std::vector<std::string> _failed_files;
 };
 
 
@@ -0,0 +1,257 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "element_pack.h"
+#include "element_loader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char PACK_MAGIC[4] = { 'S', 'S', 'E', 'P' };
+static constexpr uint32_t PACK_VERSION = 1;
+static constexpr uint32_t BYTE_ORDER_TAG = 0x01020304;
+
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t type_count;
+    uint64_t fingerprint;
+    uint32_t color_count;
+    uint32_t string_bytes;
+};
+
+struct PackRecord {
+    uint32_t id_offset, id_size;
+    uint32_t name_offset, name_size;
+    uint32_t description_offset, description_size;
+    int32_t kind;
+    int32_t density;
+    float conductivity;
+    float heat_capacity;
+    int32_t temperature;
+    uint32_t color_begin, color_count;
+};
+
+static_assert(sizeof(Color) == 4);
+
+namespace {
+
+// Read-only view of a whole file; mapped where the platform allows, read into memory otherwise
+class FileView {
+public:
+    explicit FileView(const std::string &path)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                _data = static_cast<const uint8_t*>(mapped);
+                _size = static_cast<size_t>(st.st_size);
+                _mapped = true;
+            }
+        }
+        close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return;
+        _buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        _data = reinterpret_cast<const uint8_t*>(_buffer.data());
+        _size = _buffer.size();
+#endif
+    }
+
+    ~FileView()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (_mapped)
+            munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+    }
+
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    const uint8_t *_data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;
+    std::vector<char> _buffer;
+};
+
+}
+
+uint64_t ElementPack::fingerprint(const std::string &directory)
+{
+    struct Source {
+        std::string name;
+        uintmax_t size;
+        int64_t mtime;
+    };
+    std::vector<Source> sources;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (!entry.is_regular_file(ec) || entry.path().extension() != ".xml")
+            continue;
+        const auto mtime = entry.last_write_time(ec).time_since_epoch().count();
+        sources.push_back({ entry.path().filename().string(), entry.file_size(ec), static_cast<int64_t>(mtime) });
+    }
+    std::ranges::sort(sources, {}, &Source::name);
+
+    // FNV-1a over the sorted listing
+    uint64_t hash = 0xCBF29CE484222325ull;
+    const auto mix = [&hash](const void *bytes, const size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<const uint8_t*>(bytes)[i];
+            hash *= 0x100000001B3ull;
+        }
+    };
+    for (const Source &s : sources) {
+        mix(s.name.data(), s.name.size() + 1);
+        mix(&s.size, sizeof(s.size));
+        mix(&s.mtime, sizeof(s.mtime));
+    }
+    return hash;
+}
+
+bool ElementPack::write(const std::string &path, const std::vector<ElementType*> &types, const uint64_t fingerprint)
+{
+    std::vector<PackRecord> records;
+    std::vector<Color> colors;
+    std::string strings;
+    const auto add_string = [&strings](const std::string &s, uint32_t &offset, uint32_t &size) {
+        offset = static_cast<uint32_t>(strings.size());
+        size = static_cast<uint32_t>(s.size());
+        strings += s;
+    };
+    for (const ElementType *type : types) {
+        PackRecord r {};
+        add_string(type->get_id(), r.id_offset, r.id_size);
+        add_string(type->get_name(), r.name_offset, r.name_size);
+        add_string(type->get_description(), r.description_offset, r.description_size);
+        r.kind = static_cast<int32_t>(type->get_kind());
+        r.density = type->get_density();
+        r.conductivity = type->get_conductivity();
+        r.heat_capacity = type->get_heat_capacity();
+        r.temperature = type->get_temperature();
+        r.color_begin = static_cast<uint32_t>(colors.size());
+        r.color_count = static_cast<uint32_t>(type->get_color_variants().size());
+        colors.insert(colors.end(), type->get_color_variants().begin(), type->get_color_variants().end());
+        records.push_back(r);
+    }
+
+    PackHeader header {};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.byte_order = BYTE_ORDER_TAG;
+    header.type_count = static_cast<uint32_t>(records.size());
+    header.fingerprint = fingerprint;
+    header.color_count = static_cast<uint32_t>(colors.size());
+    header.string_bytes = static_cast<uint32_t>(strings.size());
+
+    // Written next to the target and renamed over it, so readers never see half a pack
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(PackRecord)));
+        out.write(reinterpret_cast<const char*>(colors.data()), static_cast<std::streamsize>(colors.size() * sizeof(Color)));
+        out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+        if (!out)
+            return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+bool ElementPack::read(const std::string &path, const uint64_t fingerprint, std::vector<ElementType*> &out)
+{
+    const FileView file(path);
+    if (file.size() < sizeof(PackHeader))
+        return false;
+
+    PackHeader header {};
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION
+        || header.byte_order != BYTE_ORDER_TAG || header.fingerprint != fingerprint)
+        return false;
+
+    const size_t records_at = sizeof(PackHeader);
+    const size_t colors_at = records_at + static_cast<size_t>(header.type_count) * sizeof(PackRecord);
+    const size_t strings_at = colors_at + static_cast<size_t>(header.color_count) * sizeof(Color);
+    if (file.size() != strings_at + header.string_bytes)
+        return false;
+    const char *strings = reinterpret_cast<const char*>(file.data() + strings_at);
+    const auto string_at = [&](const uint32_t offset, const uint32_t size, std::string &s) {
+        if (offset > header.string_bytes || size > header.string_bytes - offset)
+            return false;
+        s.assign(strings + offset, size);
+        return true;
+    };
+
+    std::vector<ElementType*> types;
+    types.reserve(header.type_count);
+    const auto fail = [&types] {
+        for (const ElementType *t : types) {
+            delete t;
+        }
+        return false;
+    };
+    for (uint32_t i = 0; i < header.type_count; ++i) {
+        PackRecord r {};
+        std::memcpy(&r, file.data() + records_at + i * sizeof(PackRecord), sizeof(r));
+
+        std::string id, name, description;
+        if (!string_at(r.id_offset, r.id_size, id) || !string_at(r.name_offset, r.name_size, name)
+            || !string_at(r.description_offset, r.description_size, description)
+            || r.color_begin > header.color_count || r.color_count > header.color_count - r.color_begin)
+            return fail();
+
+        ElementType *t = ElementLoader::create_by_kind(static_cast<ElementKind>(r.kind));
+        if (t == nullptr)
+            return fail();
+        types.push_back(t);
+        t->set_id(id)
+         ->set_name(name)
+         ->set_description(description)
+         ->set_density(r.density)
+         ->set_conductivity(r.conductivity)
+         ->set_heat_capacity(r.heat_capacity)
+         ->set_temperature(r.temperature);
+        for (uint32_t c = 0; c < r.color_count; ++c) {
+            Color color;
+            std::memcpy(&color, file.data() + colors_at + (r.color_begin + c) * sizeof(Color), sizeof(Color));
+            t->add_color_variant(color);
+        }
+    }
+
+    out.insert(out.end(), types.begin(), types.end());
+    return true;
+}
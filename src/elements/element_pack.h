@@ -0,0 +1,39 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_ELEMENT_PACK_H
+#define SANDSTONE_ELEMENT_PACK_H
+
+#include "element_type.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compiled form of a directory of element XML files, stored as one flat binary file.
+ *
+ * The file is a header, a table of fixed-size records, every colour and one string blob, all
+ * in native layout so it can be mapped and read in place. The header carries a fingerprint of
+ * the source directory (file names, sizes and modification times); a pack whose fingerprint
+ * no longer matches is stale and gets rebuilt from the XML.
+ */
+class ElementPack {
+public:
+    static constexpr const char* FILE_NAME = "elements.pack";
+
+    // Fingerprint of every .xml file in `directory`; cheap, it only stats the files
+    static uint64_t fingerprint(const std::string &directory);
+
+    static bool write(const std::string &path, const std::vector<ElementType*> &types, uint64_t fingerprint);
+
+    /**
+     * @brief Build the element types stored in the pack at `path`.
+     * @return false, with `out` untouched, if the file is missing, malformed, from another
+     *         version or byte order, or was built from a different fingerprint.
+     */
+    static bool read(const std::string &path, uint64_t fingerprint, std::vector<ElementType*> &out);
+};
+
+#endif //SANDSTONE_ELEMENT_PACK_H
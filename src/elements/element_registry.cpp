@@ -3,8 +3,122 @@
 //
 
 #include "element_registry.h"
+#include "empty.h"
+#include "../utils/element_type_checker.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <ranges>
+
+SharedElementRegistry ElementRegistry::load_shared(const std::string &path)
+{
+    auto registry = std::make_shared<ElementRegistry>(path);
+    registry->initialize();
+    return registry;
+}
 
 std::vector<ElementType*> ElementRegistry::_load_specific() {
     return loader.load_all();
 }
 
+void ElementRegistry::_on_loaded() {
+    // Index 0 must be nothing at all: empty cells, occupancy bitmaps and the granular engine's
+    // sink masks all rely on it. A missing or miskinded EMPTY.xml gets the built-in one.
+    if (const auto it = types.find("EMPTY"); it == types.end() || it->second->get_kind() != ElementKind::Empty) {
+        if (it != types.end())
+            delete it->second;
+        ElementType *empty = new Empty();
+        empty->set_id("EMPTY")
+             ->set_name("Empty")
+             ->set_density(5)
+             ->set_conductivity(0.05f)
+             ->set_heat_capacity(1.0f);
+        empty->add_color_variant({ 0, 0, 0, 0 });
+        types["EMPTY"] = empty;
+    }
+
+    std::vector<ElementType*> ordered;
+    ordered.reserve(types.size());
+    for (const auto &type : types | std::views::values) {
+        ordered.push_back(type);
+    }
+    std::ranges::sort(ordered, [](const ElementType *a, const ElementType *b) {
+        const bool a_empty = a->get_id() == "EMPTY";
+        const bool b_empty = b->get_id() == "EMPTY";
+        if (a_empty != b_empty)
+            return a_empty;
+        return a->get_id() < b->get_id();
+    });
+
+    _types_by_index.clear();
+    _kinds.clear();
+    _movable.clear();
+    _densities.clear();
+    _conductivities.clear();
+    _inv_heat_capacities.clear();
+    _palette.clear();
+    _palette_offsets.clear();
+
+    for (ElementType *type : ordered) {
+        type->set_index(static_cast<ElementIndex>(_types_by_index.size()));
+        _types_by_index.push_back(type);
+        _kinds.push_back(type->get_kind());
+        _movable.push_back(ElementTypeChecker::is_any_of_kinds(*type,
+            { ElementKind::Liquid, ElementKind::MovableSolid, ElementKind::Gas }));
+        _densities.push_back(type->get_density());
+        _conductivities.push_back(type->get_conductivity());
+        _inv_heat_capacities.push_back(1.0f / type->get_heat_capacity());
+        _palette_offsets.push_back(static_cast<int>(_palette.size()));
+        const auto &colors = type->get_color_variants();
+        _palette.insert(_palette.end(), colors.begin(), colors.end());
+        if (colors.empty())
+            _palette.push_back({ 0, 0, 0, 0 });
+    }
+
+    // Sentinel wall for the CellMatrix border: immovable, undisplaceable and insulating.
+    // It only exists in the flat tables, never as an ElementType.
+    _wall_index = static_cast<ElementIndex>(_types_by_index.size());
+    _kinds.push_back(ElementKind::ImmovableSolid);
+    _movable.push_back(false);
+    _densities.push_back(INT_MAX);
+    _conductivities.push_back(0.0f);
+    _inv_heat_capacities.push_back(1.0f);
+    _palette_offsets.push_back(static_cast<int>(_palette.size()));
+    _palette.push_back({ 0, 0, 0, 0 });
+
+    build_packed_palette();
+}
+
+std::vector<ElementIndex> ElementRegistry::get_remap_to(const ElementRegistry &next) const
+{
+    std::vector<ElementIndex> remap(_types_by_index.size() + 1, EMPTY_INDEX);
+    for (const ElementType *type : _types_by_index) {
+        if (const ElementType *match = next.get_type_by_id(type->get_id()))
+            remap[type->get_index()] = match->get_index();
+    }
+    remap[_wall_index] = next.get_wall_index();
+    return remap;
+}
+
+void ElementRegistry::build_packed_palette()
+{
+    static_assert(sizeof(Color) == sizeof(uint32_t));
+
+    int max_variants = 1;
+    for (size_t i = 0; i + 1 < _palette_offsets.size(); ++i) {
+        max_variants = std::max(max_variants, _palette_offsets[i + 1] - _palette_offsets[i]);
+    }
+    _packed_palette_shift = std::bit_width(static_cast<unsigned>(max_variants - 1));
+
+    const int row_size = 1 << _packed_palette_shift;
+    _packed_palette.assign(_palette_offsets.size() * row_size, 0);
+    for (size_t i = 0; i < _palette_offsets.size(); ++i) {
+        const int begin = _palette_offsets[i];
+        const int end = i + 1 < _palette_offsets.size() ? _palette_offsets[i + 1] : static_cast<int>(_palette.size());
+        for (int v = 0; v < row_size; ++v) {
+            std::memcpy(&_packed_palette[i * row_size + v], &_palette[begin + v % (end - begin)], sizeof(uint32_t));
+        }
+    }
+}
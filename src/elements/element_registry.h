@@ -5,17 +5,95 @@
 #ifndef ELEMENT_REGISTRY_H
 #define ELEMENT_REGISTRY_H
 
+#include <memory>
+
 #include "element_type.h"
 #include "element_loader.h"
 #include "../core/abstract/base_registry.h"
 
+class ElementRegistry;
+
+// A loaded registry that is never modified again, shared by any number of simulations
+using SharedElementRegistry = std::shared_ptr<const ElementRegistry>;
 
+/**
+ * @brief Owns every ElementType and the flat per-index property tables used by the hot paths.
+ *
+ * Indices are dense and assigned on every load: EMPTY always gets EMPTY_INDEX, the remaining
+ * elements follow in id order so the numbering is stable across runs. A built-in EMPTY stands
+ * in when the directory has none (or one of another kind), so the index is never taken. The flat tables hold
+ * one extra entry past the last element, the wall sentinel used for CellMatrix borders.
+ *
+ * Simulations share registries as immutable SharedElementRegistry snapshots, which any number
+ * of threads may read without locking. Updating means loading a new snapshot and handing it
+ * to each simulation (Simulation::set_registry); a snapshot is freed with its last user.
+ */
 class ElementRegistry final : public BaseRegistry<ElementType, ElementLoader> {
 public:
     using BaseRegistry::BaseRegistry; // Inherit constructors
 
+    static constexpr ElementIndex EMPTY_INDEX = 0;
+
+    // Load the elements under `path` into a new immutable snapshot
+    static SharedElementRegistry load_shared(const std::string &path);
+    // Element files that failed to parse in the last load; their elements are missing
+    const std::vector<std::string>& get_failed_files() const { return loader.get_failed_files(); }
+
+    size_t get_type_count() const { return _types_by_index.size(); }
+    ElementIndex get_wall_index() const { return _wall_index; }
+    const ElementType* get_type_by_index(const ElementIndex index) const { return _types_by_index[index]; }
+
+    ElementKind get_kind(const ElementIndex index) const { return _kinds[index]; }
+    // Liquids, movable solids and gases; the only kinds step() has to visit
+    bool is_movable(const ElementIndex index) const { return _movable[index]; }
+    int get_density(const ElementIndex index) const { return _densities[index]; }
+    float get_conductivity(const ElementIndex index) const { return _conductivities[index]; }
+    float get_inv_heat_capacity(const ElementIndex index) const { return _inv_heat_capacities[index]; }
+    const Color& get_color(const ElementIndex index, const int variant) const
+    {
+        return _palette[_palette_offsets[index] + variant];
+    }
+    // Valid variants of `index` (at least 1; colourless types get a transparent placeholder)
+    int get_color_count(const ElementIndex index) const
+    {
+        const size_t next = index + 1u < _palette_offsets.size() ? _palette_offsets[index + 1] : _palette.size();
+        return static_cast<int>(next) - _palette_offsets[index];
+    }
+
+    /**
+     * @brief Colours packed into the texture's RGBA byte order, one row per index.
+     * @details Every row is 1 << get_packed_palette_shift() entries long, so a cell's colour is
+     *          a single load at (index << shift) | variant. Rows of types with fewer variants
+     *          repeat their colours.
+     */
+    const uint32_t* get_packed_palette() const { return _packed_palette.data(); }
+    int get_packed_palette_shift() const { return _packed_palette_shift; }
+
+    // All types ordered by index
+    const std::vector<const ElementType*>& get_types_by_index() const { return _types_by_index; }
+
+    // Table from this registry's indices (wall included) to `next`'s, matched by id; elements
+    // missing from `next` map to EMPTY
+    std::vector<ElementIndex> get_remap_to(const ElementRegistry &next) const;
+
 protected:
     std::vector<ElementType*> _load_specific() override;
+    void _on_loaded() override;
+
+private:
+    void build_packed_palette();
+
+    std::vector<const ElementType*> _types_by_index;
+    ElementIndex _wall_index = 0;
+    std::vector<ElementKind> _kinds;
+    std::vector<uint8_t> _movable;
+    std::vector<int> _densities;
+    std::vector<float> _conductivities;
+    std::vector<float> _inv_heat_capacities;
+    std::vector<Color> _palette;
+    std::vector<int> _palette_offsets;
+    std::vector<uint32_t> _packed_palette;
+    int _packed_palette_shift = 0;
 };
 
 #endif //ELEMENT_REGISTRY_H
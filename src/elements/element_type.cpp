@@ -7,6 +7,8 @@
 #include "../core/simulation.h"
 #include "../utils/random_utils.h"
 
+#include <algorithm>
+
 const std::string& ElementType::get_id() const { return _id; }
 const std::string& ElementType::get_description() const { return _description; }
 const std::string& ElementType::get_name() const { return _name; }
@@ -22,3 +24,6 @@ ElementType* ElementType::set_description(const std::string &description) { this
 ElementType* ElementType::set_name(const std::string &name) { this->_name = name; return this; }
 ElementType* ElementType::set_density(const int density) { this->_density = density; return this; }
 ElementType* ElementType::add_color_variant(const Color &colorVariant) { this->_color_variants.push_back(colorVariant); return this; }
+// Clamped so the explicit heat diffusion step stays stable
+ElementType* ElementType::set_conductivity(const float conductivity) { this->_conductivity = std::clamp(conductivity, 0.0f, 1.0f); return this; }
+ElementType* ElementType::set_heat_capacity(const float heat_capacity) { this->_heat_capacity = std::max(1.0f, heat_capacity); return this; }
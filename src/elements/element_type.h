@@ -7,12 +7,16 @@
 
 #include "raylib.h"
 
+#include <cstdint>
 #include <list>
 #include <string>
 #include <vector>
 
 class CellMatrix;
 
+// Dense per-registry element id, assigned at load time and stored in cells
+using ElementIndex = uint16_t;
+
 enum class ElementKind {
     Unknown = 0,
     Empty,
@@ -30,6 +34,10 @@ protected:
     int _density = 0;
     std::vector<Color> _color_variants;
     ElementKind _kind = ElementKind::Unknown;
+    ElementIndex _index = 0;
+    float _conductivity = 0.0f; // 0 (insulator) to 1
+    float _heat_capacity = 1.0f; // >= 1; higher heats up slower
+    int _temperature = 25; // Temperature new cells of this element start with
 
 public:
     virtual ~ElementType() = default;
@@ -39,6 +47,10 @@ public:
     int get_density() const;
     const std::vector<Color>& get_color_variants() const;
     ElementKind get_kind() const { return _kind; }
+    ElementIndex get_index() const { return _index; }
+    float get_conductivity() const { return _conductivity; }
+    float get_heat_capacity() const { return _heat_capacity; }
+    int get_temperature() const { return _temperature; }
 
     const Color& get_color(int index) const;
     int get_random_color_index() const;
@@ -50,6 +62,10 @@ public:
     ElementType* set_density(int density);
     ElementType* add_color_variant(const Color &colorVariant);
     ElementType* set_kind(ElementKind kind) { _kind = kind; return this; }
+    ElementType* set_index(ElementIndex index) { _index = index; return this; }
+    ElementType* set_conductivity(float conductivity);
+    ElementType* set_heat_capacity(float heat_capacity);
+    ElementType* set_temperature(int temperature) { _temperature = temperature; return this; }
 
     virtual bool step_particle_at(
        CellMatrix &curr_cells,
@@ -13,11 +13,17 @@ bool Gas::step_particle_at(
     CellMatrix &curr_cells,
     CellMatrix &next_cells,
     const int x, const int y, const ElementType *type) const 
+{
+    return step(curr_cells, next_cells, x, y);
+}
+
+bool Gas::step(CellMatrix &curr_cells, CellMatrix &next_cells, const int x, const int y)
 {
     if (next_cells.is_written(x, y))
         return false;
 
     constexpr int max_dispersion = 4;
+    static_assert(max_dispersion <= CellMatrix::PADDING);
     
     const int movement_choice = RandomUtils::uniform_int(0, 99);
     
@@ -55,7 +61,7 @@ bool Gas::step_particle_at(
     }
 
     // 6. No move was possible - stay in place
-    next_cells.get(x, y) = curr_cells.get(x, y);
+    next_cells.set(x, y, curr_cells.get(x, y));
     return false;
 }
 
@@ -11,6 +11,9 @@ class Gas final : public ElementType
 {
 public:
     Gas();
+
+    // Non-virtual update shared by every gas; used by kind dispatch
+    static bool step(CellMatrix &curr_cells, CellMatrix &next_cells, int x, int y);
 public:
     bool step_particle_at(
         CellMatrix &curr_cells,
@@ -17,11 +17,17 @@ bool Liquid::step_particle_at(
     CellMatrix &curr_cells,
     CellMatrix &next_cells,
     const int x, const int y, const ElementType *type) const 
+{
+    return step(curr_cells, next_cells, x, y);
+}
+
+bool Liquid::step(CellMatrix &curr_cells, CellMatrix &next_cells, const int x, const int y)
 {
     if (next_cells.is_written(x, y))
         return false;
 
     constexpr int max_slide = 3;
+    static_assert(max_slide <= CellMatrix::PADDING);
     
     // Randomize direction choice
     int dirs[2];
@@ -57,6 +63,6 @@ bool Liquid::step_particle_at(
     }
 
     // 6. No move was possible
-    next_cells.get(x, y) = curr_cells.get(x, y);
+    next_cells.set(x, y, curr_cells.get(x, y));
     return false;
 }
\ No newline at end of file
@@ -11,6 +11,9 @@ class Liquid final : public ElementType
 {
 public:
     Liquid();
+
+    // Non-virtual update shared by every liquid; used by kind dispatch
+    static bool step(CellMatrix &curr_cells, CellMatrix &next_cells, int x, int y);
 protected:
     int _boiling_point = 0;
     int _freezing_point = 0;
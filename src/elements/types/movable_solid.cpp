@@ -18,6 +18,11 @@ bool MovableSolid::step_particle_at(
     CellMatrix &curr_cells,
     CellMatrix &next_cells,
     const int x, const int y, const ElementType *type) const
+{
+    return step(curr_cells, next_cells, x, y);
+}
+
+bool MovableSolid::step(CellMatrix &curr_cells, CellMatrix &next_cells, const int x, const int y)
 {
     // Density-based: try to move down (displace or swap if heavier)
     if (MovementUtils::try_move(curr_cells, next_cells, x, y, 0, 1)) {
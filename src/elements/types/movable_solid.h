@@ -12,6 +12,9 @@ class Simulation;
 class MovableSolid final : public Solid {
 public:
     MovableSolid();
+
+    // Non-virtual update shared by every movable solid; used by kind dispatch
+    static bool step(CellMatrix &curr_cells, CellMatrix &next_cells, int x, int y);
 public:
     bool step_particle_at(
         CellMatrix &curr_cells,
@@ -1,43 +1,64 @@
 #include "raylib.h"
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <memory>
+#include <future>
+#include <cstdio>
 
+#include "core/edit_journal.h"
 #include "core/simulation.h"
+#include "core/simulation_runner.h"
+#include "core/world_snapshot.h"
+#include "core/world_store.h"
+#include "elements/element_pack.h"
 #include "systems/input_system.h"
+#include "utils/profiler.h"
 #include "utils/random_utils.h"
 
 constexpr int VIRTUAL_WIDTH  = 200;
 constexpr int VIRTUAL_HEIGHT = 150;
 
+// Tiles of the unbounded world kept in memory; colder ones go to the on-disk cache
+constexpr size_t MAX_RESIDENT_TILES = 256;
+
+constexpr auto QUICKSAVE_PATH = "quicksave.ssw";
+constexpr auto PROFILE_TRACE_PATH = "profile.json";
+constexpr auto PROFILE_CSV_PATH = "profile.csv";
+constexpr double ELEMENTS_POLL_INTERVAL = 1.0; // Seconds between checks for edited XML
+
 constexpr int RES_SCALE = 5;
 constexpr int WINDOW_WIDTH  = VIRTUAL_WIDTH * RES_SCALE;
 constexpr int WINDOW_HEIGHT = VIRTUAL_HEIGHT * RES_SCALE;
 
 struct Graphics {
     Texture2D canvas;
-    Color *pixels;
 };
 
 class Application
 {
 public:
-    Application()
+    explicit Application(std::string record_path = "")
+        : _record_path(std::move(record_path))
     {
-        _element_registry.initialize();
+        _elements_fingerprint = ElementPack::fingerprint(_elements_path);
         _graphics = initialize_graphics(
             VIRTUAL_WIDTH, VIRTUAL_HEIGHT,
             WINDOW_WIDTH, WINDOW_HEIGHT);
 
         _sim = std::make_unique<Simulation>(VIRTUAL_WIDTH, VIRTUAL_HEIGHT, _element_registry);
 
-        for (const auto* type : _sim->get_all_element_types()) {
-            if (type->get_id() != "EMPTY") {
-                _type_ids.push_back(type->get_id());
-            }
+        if (!_record_path.empty()) {
+            const auto seed = static_cast<uint32_t>(RandomUtils::bits());
+            _journal.begin(VIRTUAL_WIDTH, VIRTUAL_HEIGHT, seed, *_element_registry);
+            _sim->set_seed(seed);
+            _sim->set_journal(&_journal);
         }
 
+        _runner = std::make_unique<SimulationRunner>(*_sim);
+        rebuild_type_ids("");
+
         _input.create_action("place_element",
             { InputCode::mouse(MOUSE_LEFT_BUTTON) });
         _input.create_action(
@@ -55,39 +76,67 @@ public:
         _input.create_action(
             "toggle_temp",
             { InputCode::key(KEY_T) });
+        _input.create_action("quicksave", { InputCode::key(KEY_F5) });
+        _input.create_action("quickload", { InputCode::key(KEY_F9) });
+        _input.create_action("pan_left", { InputCode::key(KEY_LEFT) });
+        _input.create_action("pan_right", { InputCode::key(KEY_RIGHT) });
+        _input.create_action("pan_up", { InputCode::key(KEY_UP) });
+        _input.create_action("pan_down", { InputCode::key(KEY_DOWN) });
+        _input.create_action("reload_elements", { InputCode::key(KEY_R) });
+        _input.create_action("toggle_profiler", { InputCode::key(KEY_P) });
+        _input.create_action("dump_profile", { InputCode::key(KEY_F2) });
+        _input.create_action("toggle_movement_stats", { InputCode::key(KEY_M) });
     }
 
     void run()
     {
+        // The simulation ticks on its own thread; this loop only handles input and draws
+        _runner->start();
         while (!WindowShouldClose()) {
             handle_input();
-            _sim->step();
-            if (_show_temperature) {
-                constexpr Color COLD { 30, 17, 45, 255 };
-                constexpr Color HOT  { 244, 134, 93, 255 };
-                _sim->fill_temperature_buffer(_graphics.pixels, COLD, HOT, 0, 1100);
-            } else {
-                _sim->fill_render_buffer(_graphics.pixels);
-            }
+            update_canvas();
             draw_frame();
         }
-        
+        _runner->stop();
+
         UnloadTexture(_graphics.canvas);
-        MemFree(_graphics.pixels);
         CloseWindow();
+
+        if (!_record_path.empty()) {
+            _journal.set_tick_count(_sim->get_step_count());
+            if (!_journal.save(_record_path))
+                TraceLog(LOG_WARNING, "Could not write journal to %s", _record_path.c_str());
+        }
     }
 
 private:
     Graphics _graphics;
     
-    ElementRegistry _element_registry { []{
+    std::string _elements_path { []{
         std::string p = "data/elements";
 #ifdef SANDSTONE_DATA_DIR
         p = std::string(SANDSTONE_DATA_DIR) + "/elements";
 #endif
         return p;
     }() };
+    // The registry the UI builds edits from; the simulation switches to it at a tick boundary
+    SharedElementRegistry _element_registry = ElementRegistry::load_shared(_elements_path);
+    SharedElementRegistry _world_registry = _element_registry; // Indices in _world
+    std::future<SharedElementRegistry> _registry_reload; // Built off the main thread
+    uint64_t _elements_fingerprint = 0;
+    double _next_elements_poll = 0.0;
     std::unique_ptr<Simulation> _sim;
+    std::unique_ptr<SimulationRunner> _runner;
+    // The simulation is a window onto this world, with its top-left cell at _world_origin
+    WorldStore _world { std::filesystem::temp_directory_path() };
+    Vector2I _world_origin = Vector2I(0, 0);
+    std::vector<EditCommand> _brush_edits; // Gathered during one frame, then queued at once
+    uint64_t _shown_sequence = 0; // Snapshot currently in the canvas texture
+    const FrameSnapshot *_snapshot = nullptr; // Latest acquired; valid until the next update_canvas()
+    bool _show_movement_stats = false;
+    std::vector<Color> _upload_staging; // Packed pixels of the dirty rect being uploaded
+    std::string _record_path;
+    EditJournal _journal;
     InputSystem _input;
     bool _show_temperature = false;
     
@@ -108,15 +157,97 @@ private:
         UnloadImage(init_image);
         SetTextureFilter(canvas, TEXTURE_FILTER_POINT);
 
-        const auto pixels = static_cast<Color*>(MemAlloc(virtual_width * virtual_height * sizeof(Color)));
-        memset(pixels, 0, virtual_width * virtual_height * sizeof(Color));
+        return { canvas };
+    }
 
-        return { canvas, pixels };
+    // Brush cycle order follows the registry; the selection stays on `selected_id` if it survived
+    void rebuild_type_ids(const std::string &selected_id)
+    {
+        _type_ids.clear();
+        _current_type_idx = 0;
+        for (const auto* type : _element_registry->get_types_by_index()) {
+            if (type->get_index() == ElementRegistry::EMPTY_INDEX)
+                continue;
+            if (type->get_id() == selected_id)
+                _current_type_idx = _type_ids.size();
+            _type_ids.push_back(type->get_id());
+        }
+    }
+
+    // The fingerprint is only taken when a reload actually starts, so edits made while one is
+    // running are picked up by the next poll
+    void request_element_reload()
+    {
+        if (_registry_reload.valid())
+            return;
+        _elements_fingerprint = ElementPack::fingerprint(_elements_path);
+        _registry_reload = std::async(std::launch::async, ElementRegistry::load_shared, _elements_path);
+    }
+
+    void poll_element_reload()
+    {
+        if (GetTime() >= _next_elements_poll) {
+            _next_elements_poll = GetTime() + ELEMENTS_POLL_INTERVAL;
+            if (ElementPack::fingerprint(_elements_path) != _elements_fingerprint)
+                request_element_reload();
+        }
+
+        using namespace std::chrono_literals;
+        if (!_registry_reload.valid() || _registry_reload.wait_for(0s) != std::future_status::ready)
+            return;
+        SharedElementRegistry next = _registry_reload.get();
+        // Files may have changed while it loaded
+        _next_elements_poll = 0.0;
+        // A file that did not parse (possibly caught mid-save) would have its cells erased by
+        // the switch, so the whole set is skipped; the next save triggers another attempt
+        if (!next->get_failed_files().empty()) {
+            TraceLog(LOG_WARNING, "Ignoring element reload: could not parse %s",
+                next->get_failed_files().front().c_str());
+            return;
+        }
+        // Nothing but the built-in EMPTY: the directory held no elements
+        if (next->get_type_count() <= 1) {
+            TraceLog(LOG_WARNING, "Ignoring element reload from %s", _elements_path.c_str());
+            return;
+        }
+        const std::string selected_id = _type_ids[_current_type_idx];
+        _runner->push_registry(next);
+        _element_registry = std::move(next);
+        rebuild_type_ids(selected_id);
+    }
+
+    void update_canvas()
+    {
+        const FrameSnapshot *snapshot = _runner->acquire_snapshot();
+        _snapshot = snapshot;
+        if (snapshot == nullptr || snapshot->sequence == _shown_sequence)
+            return;
+
+        const ProfileScope upload_scope(ProfilePhase::TEXTURE_UPLOAD);
+        // Dirty rects are relative to the previous snapshot, so any skipped one forces a full upload
+        if (snapshot->full || snapshot->sequence != _shown_sequence + 1) {
+            UpdateTexture(_graphics.canvas, snapshot->pixels.data());
+        } else {
+            for (const Rect2I &rect : snapshot->dirty_rects) {
+                const int w = rect.get_width();
+                _upload_staging.resize(static_cast<size_t>(w) * rect.get_height());
+                for (int y = rect.min_y; y <= rect.max_y; ++y) {
+                    const Color *src = snapshot->pixels.data() + static_cast<size_t>(y) * VIRTUAL_WIDTH + rect.min_x;
+                    std::copy_n(src, w, _upload_staging.data() + static_cast<size_t>(y - rect.min_y) * w);
+                }
+                UpdateTextureRec(_graphics.canvas,
+                    Rectangle {
+                        static_cast<float>(rect.min_x), static_cast<float>(rect.min_y),
+                        static_cast<float>(w), static_cast<float>(rect.get_height())
+                    },
+                    _upload_staging.data());
+            }
+        }
+        _shown_sequence = snapshot->sequence;
     }
 
     void draw_frame() const
     {
-        UpdateTexture(_graphics.canvas, _graphics.pixels);
         BeginDrawing();
         ClearBackground(BLACK);
         DrawTexturePro(
@@ -129,6 +260,10 @@ private:
         );
         draw_cursor_outline();
         draw_overlay();
+        if (Profiler::is_enabled())
+            draw_profile_overlay();
+        if (_show_movement_stats)
+            draw_movement_overlay();
         EndDrawing();
     }
 
@@ -145,6 +280,74 @@ private:
         return brush_name_square;
     }
 
+    // Rolling mean and p99 per phase under the FPS counter, bars scaled to one 120 TPS tick
+    static void draw_profile_overlay()
+    {
+        constexpr int MARGIN = 8;
+        constexpr int FONT_SIZE = 4 * RES_SCALE;
+        constexpr int PAD = 1;
+        constexpr int BAR_WIDTH = 120;
+        constexpr double BAR_FULL_MS = 1000.0 / 120.0;
+
+        int y = MARGIN + 5 * RES_SCALE + 3 * PAD;
+        const auto draw_row = [&](const std::string &name, const Profiler::Stats &stats) {
+            char label[96];
+            std::snprintf(label, sizeof(label), "%s %.2f / %.2f ms", name.c_str(), stats.mean_ms, stats.p99_ms);
+            const int bar_x = WINDOW_WIDTH - MARGIN - BAR_WIDTH;
+            const int text_x = bar_x - PAD * 4 - MeasureText(label, FONT_SIZE);
+            DrawText(label, text_x + 1, y + 1, FONT_SIZE, BLACK);
+            DrawText(label, text_x, y, FONT_SIZE, WHITE);
+            const int filled = static_cast<int>(std::min(1.0, stats.mean_ms / BAR_FULL_MS) * BAR_WIDTH);
+            DrawRectangleLines(bar_x, y + 2, BAR_WIDTH, FONT_SIZE - 4, WHITE);
+            DrawRectangle(bar_x, y + 2, filled, FONT_SIZE - 4, GREEN);
+            y += FONT_SIZE + PAD;
+        };
+
+        for (int i = 0; i < static_cast<int>(ProfilePhase::COUNT); ++i) {
+            const auto phase = static_cast<ProfilePhase>(i);
+            draw_row(Profiler::get_phase_name(phase), Profiler::get_stats(phase));
+        }
+        for (const ElementKind kind : { ElementKind::MovableSolid, ElementKind::Liquid, ElementKind::Gas }) {
+            draw_row(std::string("  scan ") + Profiler::get_kind_name(kind), Profiler::get_kind_stats(kind));
+        }
+    }
+
+    // Last tick's counters per element, bottom-left, as shares of the cells it stepped
+    void draw_movement_overlay() const
+    {
+        if (_snapshot == nullptr)
+            return;
+        constexpr int MARGIN = 8;
+        constexpr int FONT_SIZE = 4 * RES_SCALE;
+        constexpr int PAD = 1;
+        constexpr size_t MAX_ROWS = 8;
+
+        const size_t rows = std::min(MAX_ROWS, _snapshot->movement_stats.size());
+        int y = WINDOW_HEIGHT - MARGIN - static_cast<int>(rows + 1) * (FONT_SIZE + PAD);
+        const auto draw_row = [&](const char *label) {
+            DrawText(label, MARGIN + 1, y + 1, FONT_SIZE, BLACK);
+            DrawText(label, MARGIN, y, FONT_SIZE, WHITE);
+            y += FONT_SIZE + PAD;
+        };
+
+        draw_row("Element  cells  moved  swapped  failed move/slide/wiggle/diag");
+        for (size_t i = 0; i < rows; ++i) {
+            const ElementMovementReport &report = _snapshot->movement_stats[i];
+            const MovementStats &s = report.stats;
+            const double cells = static_cast<double>(s.cells_stepped);
+            const auto failed = [&](const MovementRoutine routine) {
+                return static_cast<unsigned long long>(s.failed[static_cast<int>(routine)]);
+            };
+            char label[160];
+            std::snprintf(label, sizeof(label), "%s  %llu  %.0f%%  %.0f%%  %llu/%llu/%llu/%llu",
+                report.id.c_str(), static_cast<unsigned long long>(s.cells_stepped),
+                100.0 * s.moves / cells, 100.0 * s.swaps / cells,
+                failed(MovementRoutine::TRY_MOVE), failed(MovementRoutine::TRY_SLIDE_MOVEMENT),
+                failed(MovementRoutine::TRY_LATERAL_WIGGLE), failed(MovementRoutine::TRY_SOLID_DIAGONAL_MOVEMENT));
+            draw_row(label);
+        }
+    }
+
     void draw_overlay() const
     {
         constexpr int MARGIN = 8;
@@ -180,6 +383,31 @@ private:
         const std::string brush_mode_guide_label = "Brush Mode: Tab";
         DrawText(brush_mode_guide_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
         DrawText(brush_mode_guide_label.c_str(), pos.x, pos.y, FONT_SIZE, WHITE);
+
+        pos.y += FONT_SIZE + PAD;
+        const std::string pan_guide_label = "Arrows: Pan";
+        DrawText(pan_guide_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
+        DrawText(pan_guide_label.c_str(), pos.x, pos.y, FONT_SIZE, WHITE);
+
+        pos.y += FONT_SIZE + PAD;
+        const std::string save_guide_label = "F5/F9: Save/Load";
+        DrawText(save_guide_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
+        DrawText(save_guide_label.c_str(), pos.x, pos.y, FONT_SIZE, WHITE);
+
+        pos.y += FONT_SIZE + PAD;
+        const std::string reload_guide_label = "R: Reload elements";
+        DrawText(reload_guide_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
+        DrawText(reload_guide_label.c_str(), pos.x, pos.y, FONT_SIZE, WHITE);
+
+        pos.y += FONT_SIZE + PAD;
+        const std::string profile_guide_label = "P/F2: Profiler/Dump";
+        DrawText(profile_guide_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
+        DrawText(profile_guide_label.c_str(), pos.x, pos.y, FONT_SIZE, WHITE);
+
+        pos.y += FONT_SIZE + PAD;
+        const std::string movement_guide_label = "M: Movement stats";
+        DrawText(movement_guide_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
+        DrawText(movement_guide_label.c_str(), pos.x, pos.y, FONT_SIZE, WHITE);
         
         pos.y += FONT_SIZE + PAD+10;
         const std::string &current_type_id = _type_ids[_current_type_idx];
@@ -196,6 +424,11 @@ private:
         const std::string shape_label = std::string("Brush Shape: ") + brush_shape_name(_brush_shape);
         DrawText(shape_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
         DrawText(shape_label.c_str(), pos.x, pos.y, FONT_SIZE, GREEN);
+
+        pos.y += FONT_SIZE + PAD;
+        const std::string origin_label = "World: " + std::to_string(_world_origin.x) + ", " + std::to_string(_world_origin.y);
+        DrawText(origin_label.c_str(), pos.x + 1, pos.y + 1, FONT_SIZE, BLACK);
+        DrawText(origin_label.c_str(), pos.x, pos.y, FONT_SIZE, GREEN);
     }
 
     void draw_cursor_outline() const
@@ -227,41 +460,43 @@ private:
         }
     }
 
-    void draw_square(const Vector2I &pos, const std::string &type_id, const int half_extent) const
+    // Erasing overwrites anything; placing only fills cells still empty when the edit lands
+    void queue_edit(const int x, const int y, const ElementType *type, const bool erase)
     {
-        const auto type = _sim->get_type_by_id(type_id);
-        const bool erase = (type_id == "EMPTY");
+        _brush_edits.push_back({ Vector2I(x, y), type, type->get_random_color_index(), !erase });
+    }
+
+    void draw_square(const Vector2I &pos, const std::string &type_id, const int half_extent)
+    {
+        const auto type = _element_registry->get_type_by_id(type_id);
+        const bool erase = (type->get_index() == ElementRegistry::EMPTY_INDEX);
         for (int x = pos.x - half_extent; x <= pos.x + half_extent; ++x) {
             for (int y = pos.y - half_extent; y <= pos.y + half_extent; ++y) {
-                if (erase || _sim->is_pos_empty(x, y)) {
-                    _sim->set_type_at(x, y, type, type->get_random_color_index());
-                }
+                queue_edit(x, y, type, erase);
             }
         }
     }
 
-    void draw_round(const Vector2I &pos, const std::string &type_id, const int radius) const
+    void draw_round(const Vector2I &pos, const std::string &type_id, const int radius)
     {
-        const auto type = _sim->get_type_by_id(type_id);
-        const bool erase = (type_id == "EMPTY");
+        const auto type = _element_registry->get_type_by_id(type_id);
+        const bool erase = (type->get_index() == ElementRegistry::EMPTY_INDEX);
         const int r2 = radius * radius;
         for (int dx = -radius; dx <= radius; ++dx) {
             for (int dy = -radius; dy <= radius; ++dy) {
                 if (dx*dx + dy*dy <= r2) {
                     const int x = pos.x + dx;
                     const int y = pos.y + dy;
-                    if (erase || _sim->is_pos_empty(x, y)) {
-                        _sim->set_type_at(x, y, type, type->get_random_color_index());
-                    }
+                    queue_edit(x, y, type, erase);
                 }
             }
         }
     }
 
-    void draw_spray(const Vector2I &pos, const std::string &type_id, const int radius) const
+    void draw_spray(const Vector2I &pos, const std::string &type_id, const int radius)
     {
-        const auto type = _sim->get_type_by_id(type_id);
-        const bool erase = (type_id == "EMPTY");
+        const auto type = _element_registry->get_type_by_id(type_id);
+        const bool erase = (type->get_index() == ElementRegistry::EMPTY_INDEX);
         constexpr int COVERAGE = 15; // percent
         const int r2 = radius * radius;
         for (int dx = -radius; dx <= radius; ++dx) {
@@ -270,16 +505,14 @@ private:
                     if (RandomUtils::uniform_int(0, 99) < COVERAGE) {
                         const int x = pos.x + dx;
                         const int y = pos.y + dy;
-                        if (erase || _sim->is_pos_empty(x, y)) {
-                            _sim->set_type_at(x, y, type, type->get_random_color_index());
-                        }
+                        queue_edit(x, y, type, erase);
                     }
                 }
             }
         }
     }
 
-    void draw_at_pos(const Vector2I &pos, const std::string& type_id, const int expand_brush = 0) const
+    void draw_at_pos(const Vector2I &pos, const std::string& type_id, const int expand_brush = 0)
     {
         switch (_brush_shape) {
             case BrushShape::SQUARE:
@@ -318,8 +551,30 @@ private:
         _brush_size--;   
     }
 
+    void pan_window(const Vector2I &delta)
+    {
+        // Paging needs the simulation to itself, so the simulation thread sits out the swap
+        _runner->stop();
+        // Tiles stored before an element reload still hold the old registry's indices
+        if (_world_registry != _element_registry) {
+            _world.remap_types(_world_registry->get_remap_to(*_element_registry), *_element_registry);
+            _world_registry = _element_registry;
+        }
+        // Tiles the cache cannot give back are left alone on disk rather than overwritten
+        if (!_world.store_window(*_sim, _world_origin))
+            TraceLog(LOG_WARNING, "Could not read cached tiles in %s; parts of the window were not stored",
+                _world.get_cache_dir().string().c_str());
+        _world_origin = _world_origin + delta;
+        if (!_world.load_window(*_sim, _world_origin))
+            TraceLog(LOG_WARNING, "Could not read cached tiles in %s; parts of the window load empty",
+                _world.get_cache_dir().string().c_str());
+        _world.evict(MAX_RESIDENT_TILES);
+        _runner->start();
+    }
+
     void handle_input()
     {
+        const ProfileScope input_scope(ProfilePhase::INPUT);
         _input.update();
         
         auto [x_screen, y_screen] = _input.get_mouse_position();
@@ -338,6 +593,9 @@ private:
             draw_at_pos(Vector2I(current_mouse_pos), "EMPTY", _brush_size-1);
         }
 
+        _runner->push_edits(_brush_edits);
+        _brush_edits.clear();
+
         if (_input.is_action_just_pressed("prev_element")) {
             _current_type_idx = get_prev_type_index(_current_type_idx, _type_ids.size());
         }
@@ -351,8 +609,57 @@ private:
             _brush_shape = static_cast<BrushShape>(next);
         }
 
+        // Journals hold window coordinates, so a recorded session keeps the window in place
+        if (_record_path.empty()) {
+            Vector2I pan(0, 0);
+            if (_input.is_action_just_pressed("pan_left")) pan.x -= WorldStore::TILE_SIZE;
+            if (_input.is_action_just_pressed("pan_right")) pan.x += WorldStore::TILE_SIZE;
+            if (_input.is_action_just_pressed("pan_up")) pan.y -= WorldStore::TILE_SIZE;
+            if (_input.is_action_just_pressed("pan_down")) pan.y += WorldStore::TILE_SIZE;
+            if (pan.x != 0 || pan.y != 0)
+                pan_window(pan);
+        }
+
+        if (_input.is_action_just_pressed("quicksave")) {
+            _runner->stop();
+            if (!WorldSnapshot::save(*_sim, QUICKSAVE_PATH))
+                TraceLog(LOG_WARNING, "Could not write world to %s", QUICKSAVE_PATH);
+            _runner->start();
+        }
+
+        // Loading would also desynchronise a recording from its journal
+        if (_record_path.empty() && _input.is_action_just_pressed("quickload")) {
+            _runner->stop();
+            if (!WorldSnapshot::load(*_sim, QUICKSAVE_PATH))
+                TraceLog(LOG_WARNING, "Could not load world from %s", QUICKSAVE_PATH);
+            _runner->start();
+        }
+
+        // A journal replays against the registry it was recorded with
+        if (_record_path.empty()) {
+            if (_input.is_action_just_pressed("reload_elements"))
+                request_element_reload();
+            poll_element_reload();
+        }
+
+        if (_input.is_action_just_pressed("toggle_profiler")) {
+            Profiler::reset();
+            Profiler::set_enabled(!Profiler::is_enabled());
+        }
+
+        if (_input.is_action_just_pressed("toggle_movement_stats")) {
+            _show_movement_stats = !_show_movement_stats;
+            _runner->set_movement_stats(_show_movement_stats);
+        }
+
+        if (_input.is_action_just_pressed("dump_profile")) {
+            if (!Profiler::write_chrome_trace(PROFILE_TRACE_PATH) || !Profiler::write_csv(PROFILE_CSV_PATH))
+                TraceLog(LOG_WARNING, "Could not write profile to %s / %s", PROFILE_TRACE_PATH, PROFILE_CSV_PATH);
+        }
+
         if (_input.is_action_just_pressed("toggle_temp")) {
             _show_temperature = !_show_temperature;
+            _runner->set_temperature_view(_show_temperature);
         }
 
         // Mouse wheel adjusts brush size
@@ -366,9 +673,16 @@ private:
     }
 };
 
-int main()
+int main(const int argc, char **argv)
 {
-    Application app;
+    // --record <file> journals every edit for headless replay (see sandstone_bench --replay)
+    std::string record_path;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--record")
+            record_path = argv[i + 1];
+    }
+
+    Application app(record_path);
     app.run();
     
     return 0;
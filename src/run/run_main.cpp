@@ -0,0 +1,274 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+// Headless batch runner. Each job loads a world saved by WorldSnapshot, runs it for a number
+// of ticks with a fixed seed and writes <out>.ssw (the final world) and <out>.json (metrics).
+// Jobs run concurrently, one single-threaded Simulation per worker, all sharing one registry.
+//
+// Usage: sandstone_run --scene FILE --ticks N [--seed N] --out PREFIX [options]
+//        sandstone_run --jobs FILE [options]
+// Options: [--workers N] [--settle N]
+//
+// A jobs file lists one job per line as "SCENE TICKS SEED OUT_PREFIX"; blank lines and lines
+// starting with '#' are skipped. --settle N ends a job early once a tick scans at most N
+// chunks (see Simulation::step_n). Every job needs its own output prefix. A summary JSON goes
+// to stdout.
+
+#include "../core/simulation.h"
+#include "../core/thread_pool.h"
+#include "../core/world_snapshot.h"
+#include "../elements/element_registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+struct RunJob {
+    std::string scene_path;
+    int ticks = 0;
+    uint32_t seed = 0;
+    std::string out_prefix;
+};
+
+struct RunOptions {
+    std::vector<RunJob> jobs;
+    int workers = 0; // 0: one per hardware thread
+    int settled_awake_chunks = Simulation::NEVER_SETTLE;
+};
+
+static bool read_jobs(const std::string &path, std::vector<RunJob> &jobs)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+        std::istringstream fields(line);
+        RunJob job;
+        if (!(fields >> job.scene_path >> job.ticks >> job.seed >> job.out_prefix) || job.ticks < 0) {
+            std::fprintf(stderr, "%s:%d: expected \"SCENE TICKS SEED OUT_PREFIX\"\n", path.c_str(), line_number);
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+static bool parse_args(const int argc, char **argv, RunOptions &opts)
+{
+    RunJob single;
+    bool has_single = false;
+    bool has_ticks = false;
+    bool has_single_option = false; // --ticks, --seed or --out, which only go with --scene
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            std::fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (std::strcmp(arg, "--scene") == 0) {
+            single.scene_path = value;
+            has_single = true;
+        } else if (std::strcmp(arg, "--ticks") == 0) {
+            single.ticks = std::max(0, std::atoi(value));
+            has_ticks = true;
+            has_single_option = true;
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            single.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            has_single_option = true;
+        } else if (std::strcmp(arg, "--out") == 0) {
+            single.out_prefix = value;
+            has_single_option = true;
+        } else if (std::strcmp(arg, "--jobs") == 0) {
+            if (!read_jobs(value, opts.jobs)) {
+                std::fprintf(stderr, "could not read jobs: %s\n", value);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--workers") == 0) {
+            opts.workers = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--settle") == 0) {
+            opts.settled_awake_chunks = std::max(0, std::atoi(value));
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+        }
+        ++i;
+    }
+
+    if (has_single) {
+        if (!has_ticks || single.out_prefix.empty()) {
+            std::fprintf(stderr, "--scene needs --ticks and --out\n");
+            return false;
+        }
+        opts.jobs.push_back(single);
+    } else if (has_single_option) {
+        std::fprintf(stderr, "--ticks, --seed and --out only apply to --scene\n");
+        return false;
+    }
+    if (opts.jobs.empty()) {
+        std::fprintf(stderr, "nothing to run: give --scene or --jobs\n");
+        return false;
+    }
+    // Jobs run concurrently, so two sharing a prefix would write the same files at once
+    std::unordered_set<std::string> prefixes;
+    for (const RunJob &job : opts.jobs) {
+        const std::string prefix = std::filesystem::absolute(job.out_prefix).lexically_normal().string();
+        if (!prefixes.insert(prefix).second) {
+            std::fprintf(stderr, "more than one job writes to %s\n", job.out_prefix.c_str());
+            return false;
+        }
+    }
+    if (opts.workers == 0)
+        opts.workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    return true;
+}
+
+// Quotes text as a JSON string, escaping quotes, backslashes and control characters
+static std::string json_string(const std::string &text)
+{
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            // JSON forbids raw control characters in strings
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static bool write_metrics(const std::string &path, const RunJob &job, const Simulation &sim,
+    const int ticks_run, const double seconds)
+{
+    const ElementRegistry &registry = sim.get_registry();
+    std::vector<uint64_t> counts(registry.get_type_count() + 1, 0);
+    for (int y = 0; y < sim.get_height(); ++y) {
+        for (int x = 0; x < sim.get_width(); ++x) {
+            counts[sim.get_cell(x, y).type]++;
+        }
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+    out << "{\n"
+        << "  \"scene\": " << json_string(job.scene_path) << ",\n"
+        << "  \"seed\": " << job.seed << ",\n"
+        << "  \"width\": " << sim.get_width() << ",\n"
+        << "  \"height\": " << sim.get_height() << ",\n"
+        << "  \"ticks_requested\": " << job.ticks << ",\n"
+        << "  \"ticks_run\": " << ticks_run << ",\n"
+        << "  \"seconds\": " << seconds << ",\n"
+        << "  \"ticks_per_sec\": " << (seconds > 0.0 ? ticks_run / seconds : 0.0) << ",\n"
+        << "  \"awake_chunks\": " << sim.get_awake_chunk_count() << ",\n";
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(sim.get_state_hash()));
+    out << "  \"state_hash\": \"" << hash << "\",\n"
+        << "  \"cells\": {";
+    bool first = true;
+    for (const ElementType *type : registry.get_types_by_index()) {
+        if (counts[type->get_index()] == 0)
+            continue;
+        out << (first ? "" : ", ") << json_string(type->get_id()) << ": " << counts[type->get_index()];
+        first = false;
+    }
+    out << "}\n}\n";
+    return static_cast<bool>(out);
+}
+
+static bool run_job(const SharedElementRegistry &registry, const RunJob &job, const RunOptions &opts)
+{
+    Vector2I size;
+    if (!WorldSnapshot::read_size(job.scene_path, size)) {
+        std::fprintf(stderr, "not a world file: %s\n", job.scene_path.c_str());
+        return false;
+    }
+    Simulation sim(size, registry);
+    if (!WorldSnapshot::load(sim, job.scene_path)) {
+        std::fprintf(stderr, "could not load world: %s\n", job.scene_path.c_str());
+        return false;
+    }
+    sim.set_seed(job.seed);
+
+    // Outputs may go to a directory that does not exist yet
+    const std::filesystem::path out_dir = std::filesystem::path(job.out_prefix).parent_path();
+    std::error_code ec;
+    if (!out_dir.empty() && !std::filesystem::create_directories(out_dir, ec) && ec) {
+        std::fprintf(stderr, "could not create output directory: %s\n", out_dir.string().c_str());
+        return false;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const int ticks_run = sim.step_n(job.ticks, opts.settled_awake_chunks);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (!WorldSnapshot::save(sim, job.out_prefix + ".ssw")) {
+        std::fprintf(stderr, "could not write world: %s.ssw\n", job.out_prefix.c_str());
+        return false;
+    }
+    if (!write_metrics(job.out_prefix + ".json", job, sim, ticks_run, seconds)) {
+        std::fprintf(stderr, "could not write metrics: %s.json\n", job.out_prefix.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(const int argc, char **argv)
+{
+    RunOptions opts;
+    if (!parse_args(argc, argv, opts))
+        return 1;
+
+    std::string data_dir = "data";
+#ifdef SANDSTONE_DATA_DIR
+    data_dir = SANDSTONE_DATA_DIR;
+#endif
+    // Loaded once; every job's simulation shares this snapshot
+    const SharedElementRegistry registry = ElementRegistry::load_shared(data_dir + "/elements");
+    if (registry->get_type_count() <= 1) {
+        std::fprintf(stderr, "no elements found in %s/elements\n", data_dir.c_str());
+        return 1;
+    }
+
+    // Jobs are independent and single-threaded, so throughput scales with the workers
+    ThreadPool pool(std::min(opts.workers, static_cast<int>(opts.jobs.size())));
+    std::atomic<int> failed { 0 };
+    const auto t0 = std::chrono::steady_clock::now();
+    pool.parallel_for(static_cast<int>(opts.jobs.size()), [&](const int i) {
+        if (!run_job(registry, opts.jobs[i], opts))
+            failed.fetch_add(1, std::memory_order_relaxed);
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::printf("{\n");
+    std::printf("  \"jobs\": %zu,\n", opts.jobs.size());
+    std::printf("  \"failed\": %d,\n", failed.load());
+    std::printf("  \"workers\": %d,\n", pool.get_thread_count());
+    std::printf("  \"seconds\": %.3f,\n", seconds);
+    std::printf("  \"jobs_per_sec\": %.2f\n", seconds > 0.0 ? opts.jobs.size() / seconds : 0.0);
+    std::printf("}\n");
+    return failed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "rect2i.h"
+
+#include <algorithm>
+
+bool Rect2I::contains(const int x, const int y) const
+{
+    return x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+}
+
+int Rect2I::get_width() const
+{
+    return is_empty() ? 0 : max_x - min_x + 1;
+}
+
+int Rect2I::get_height() const
+{
+    return is_empty() ? 0 : max_y - min_y + 1;
+}
+
+void Rect2I::include(const int x, const int y)
+{
+    min_x = std::min(min_x, x);
+    min_y = std::min(min_y, y);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+}
+
+void Rect2I::include(const Rect2I &other)
+{
+    if (other.is_empty())
+        return;
+    min_x = std::min(min_x, other.min_x);
+    min_y = std::min(min_y, other.min_y);
+    max_x = std::max(max_x, other.max_x);
+    max_y = std::max(max_y, other.max_y);
+}
+
+Rect2I Rect2I::intersected(const Rect2I &other) const
+{
+    return {
+        std::max(min_x, other.min_x),
+        std::max(min_y, other.min_y),
+        std::min(max_x, other.max_x),
+        std::min(max_y, other.max_y)
+    };
+}
+
+void Rect2I::clear()
+{
+    *this = Rect2I();
+}
@@ -0,0 +1,37 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_RECT2I_H
+#define SANDSTONE_RECT2I_H
+
+#include <climits>
+
+/**
+ * @brief Inclusive integer rectangle in cell coordinates.
+ *
+ * Default-constructed rects are empty (min > max), so they can be grown with include().
+ */
+struct Rect2I
+{
+    int min_x = INT_MAX;
+    int min_y = INT_MAX;
+    int max_x = INT_MIN;
+    int max_y = INT_MIN;
+
+    Rect2I() = default;
+    Rect2I(const int min_x, const int min_y, const int max_x, const int max_y)
+        : min_x(min_x), min_y(min_y), max_x(max_x), max_y(max_y) {}
+
+    bool is_empty() const { return min_x > max_x || min_y > max_y; }
+    bool contains(int x, int y) const;
+    int get_width() const;
+    int get_height() const;
+
+    void include(int x, int y);
+    void include(const Rect2I &other);
+    Rect2I intersected(const Rect2I &other) const;
+    void clear();
+};
+
+#endif //SANDSTONE_RECT2I_H
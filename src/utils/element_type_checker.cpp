@@ -7,17 +7,32 @@
 
 bool ElementTypeChecker::is_empty(const ElementType &element) noexcept
 {
-    return element.get_kind() == ElementKind::Empty;
+    return is_empty(element.get_kind());
 }
 
 bool ElementTypeChecker::is_of_kind(const ElementType &element, const ElementKind kind) noexcept
 {
-    return element.get_kind() == kind;
+    return is_of_kind(element.get_kind(), kind);
 }
 
 bool ElementTypeChecker::is_any_of_kinds(const ElementType &element, const std::initializer_list<ElementKind> kinds) noexcept
 {
-    const ElementKind k = element.get_kind();
+    return is_any_of_kinds(element.get_kind(), kinds);
+}
+
+bool ElementTypeChecker::is_empty(const ElementKind element_kind) noexcept
+{
+    return element_kind == ElementKind::Empty;
+}
+
+bool ElementTypeChecker::is_of_kind(const ElementKind element_kind, const ElementKind kind) noexcept
+{
+    return element_kind == kind;
+}
+
+bool ElementTypeChecker::is_any_of_kinds(const ElementKind element_kind, const std::initializer_list<ElementKind> kinds) noexcept
+{
+    const ElementKind k = element_kind;
     for (const auto kk : kinds) {
         if (kk == k) return true;
     }
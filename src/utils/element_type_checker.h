@@ -13,6 +13,11 @@ public:
     static bool is_empty(const ElementType& element) noexcept;
     static bool is_of_kind(const ElementType& element, ElementKind kind) noexcept;
     static bool is_any_of_kinds(const ElementType& element, std::initializer_list<ElementKind> kinds) noexcept;
+
+    // Same checks on a kind already looked up from the registry tables
+    static bool is_empty(ElementKind element_kind) noexcept;
+    static bool is_of_kind(ElementKind element_kind, ElementKind kind) noexcept;
+    static bool is_any_of_kinds(ElementKind element_kind, std::initializer_list<ElementKind> kinds) noexcept;
 };
 
 #endif //SANDSTONE_ELEMENT_UTIL_H
\ No newline at end of file
@@ -0,0 +1,67 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_MOVEMENT_STATS_H
+#define SANDSTONE_MOVEMENT_STATS_H
+
+#include <array>
+#include <cstdint>
+
+// The MovementUtils routines whose failed attempts are counted
+enum class MovementRoutine {
+    TRY_MOVE = 0,
+    TRY_SLIDE_MOVEMENT,
+    TRY_LATERAL_WIGGLE,
+    TRY_SOLID_DIAGONAL_MOVEMENT,
+    COUNT
+};
+
+/**
+ * @brief What the cells of one element did over a tick (or several, summed).
+ *
+ * While Simulation gathers stats, `current` points at the counters of the element being stepped
+ * on this thread and MovementUtils counts into it; otherwise it is null and nothing is counted.
+ */
+struct MovementStats {
+    static constexpr int ROUTINE_COUNT = static_cast<int>(MovementRoutine::COUNT);
+
+    uint64_t cells_stepped = 0;
+    uint64_t moves = 0; // Into an empty cell
+    uint64_t swaps = 0; // With an occupied cell, by density
+    std::array<uint64_t, ROUTINE_COUNT> failed {}; // Calls that moved nothing, per routine
+
+    static inline thread_local MovementStats *current = nullptr;
+
+    void merge(const MovementStats &other)
+    {
+        cells_stepped += other.cells_stepped;
+        moves += other.moves;
+        swaps += other.swaps;
+        for (int i = 0; i < ROUTINE_COUNT; ++i) {
+            failed[i] += other.failed[i];
+        }
+    }
+
+    uint64_t get_failed_total() const
+    {
+        uint64_t total = 0;
+        for (const uint64_t count : failed) {
+            total += count;
+        }
+        return total;
+    }
+
+    static const char* get_routine_name(const MovementRoutine routine)
+    {
+        switch (routine) {
+            case MovementRoutine::TRY_MOVE: return "try_move";
+            case MovementRoutine::TRY_SLIDE_MOVEMENT: return "try_slide_movement";
+            case MovementRoutine::TRY_LATERAL_WIGGLE: return "try_lateral_wiggle";
+            case MovementRoutine::TRY_SOLID_DIAGONAL_MOVEMENT: return "try_solid_diagonal_movement";
+            default: return "unknown";
+        }
+    }
+};
+
+#endif //SANDSTONE_MOVEMENT_STATS_H
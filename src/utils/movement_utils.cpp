@@ -8,6 +8,17 @@
 #include "../core/cell_matrix.h"
 #include "../core/cell_data.h"
 #include "../utils/random_utils.h"
+#include "movement_stats.h"
+
+// Counts a call that moved nothing against the element being stepped, when stats are gathered
+static bool count_attempt(const MovementRoutine routine, const bool moved)
+{
+    if (!moved) {
+        if (MovementStats *stats = MovementStats::current)
+            stats->failed[static_cast<int>(routine)]++;
+    }
+    return moved;
+}
 
 bool MovementUtils::move_cell(
     CellMatrix &curr_cells,
@@ -15,49 +26,44 @@ bool MovementUtils::move_cell(
     const int src_x, const int src_y,
     const int dest_x, const int dest_y)
 {
-    if (!curr_cells.within_bounds(dest_x, dest_y)) {
-        return false;
-    }
-
     if (next_cells.is_written(dest_x, dest_y)) {
         return false;
     }
 
-    const ElementType* dest_type = next_cells.get_type(dest_x, dest_y);
-    next_cells.get(dest_x, dest_y) = curr_cells.get(src_x, src_y);
-    next_cells.get(src_x, src_y) = { dest_type, 0, 0, 0 };
+    const ElementIndex dest_type = next_cells.get_index(dest_x, dest_y);
+    const float dest_temp = next_cells.get_temp(dest_x, dest_y);
+    next_cells.set(dest_x, dest_y, curr_cells.get(src_x, src_y));
+    next_cells.set(src_x, src_y, { dest_type, 0, 0, 0, dest_temp });
     next_cells.mark_written(dest_x, dest_y);
+    next_cells.wake(src_x, src_y);
+    next_cells.wake(dest_x, dest_y);
+    if (MovementStats *stats = MovementStats::current)
+        stats->moves++;
     return true;
 }
 
-static int density_of(const ElementType* t)
-{
-    return t ? t->get_density() : 0;
-}
-
 bool MovementUtils::can_displace(
     const CellMatrix &curr_cells,
     const CellMatrix &next_cells,
     const int x, const int y,
     const int nx, const int ny)
 {
-    if (!curr_cells.within_bounds(nx, ny)) return false;
-
-    const ElementType* src = next_cells.get_type(x, y);
-    const ElementType* dst = next_cells.get_type(nx, ny);
-    if (!src || !dst) return false;
+    const ElementRegistry &registry = next_cells.get_registry();
+    const ElementIndex src = next_cells.get_index(x, y);
+    const ElementIndex dst = next_cells.get_index(nx, ny);
+    const ElementKind dst_kind = registry.get_kind(dst);
 
     // Immovable solid at destination: never displace
-    if (ElementTypeChecker::is_of_kind(*dst, ElementKind::ImmovableSolid))
+    if (ElementTypeChecker::is_of_kind(dst_kind, ElementKind::ImmovableSolid))
         return false;
 
     // Source immovable: it shouldn't be trying to move anyway
-    if (ElementTypeChecker::is_of_kind(*src, ElementKind::ImmovableSolid))
+    if (ElementTypeChecker::is_of_kind(registry.get_kind(src), ElementKind::ImmovableSolid))
         return false;
 
     const int dy = ny - y;
-    const int s = density_of(src);
-    const int d = density_of(dst);
+    const int s = registry.get_density(src);
+    const int d = registry.get_density(dst);
 
     if (dy > 0) { // moving down
         return s > d;
@@ -68,7 +74,7 @@ bool MovementUtils::can_displace(
     
     // lateral
     // Allow moving into EMPTY, or displace when source is denser than destination
-    if (ElementTypeChecker::is_empty(*dst)) return true;
+    if (ElementTypeChecker::is_empty(dst_kind)) return true;
     return s > d;
 }
 
@@ -78,15 +84,12 @@ bool MovementUtils::swap_or_move(
     const int x, const int y,
     const int nx, const int ny)
 {
-    if (!curr_cells.within_bounds(nx, ny)) return false;
     if (next_cells.is_written(nx, ny)) return false;
 
     const int dest_idx_taken = next_cells.flatten_coords(nx, ny);
     (void)dest_idx_taken;
 
-    const ElementType* dst_type = next_cells.get_type(nx, ny);
-
-    if (ElementTypeChecker::is_empty(*dst_type)) {
+    if (next_cells.is_empty(nx, ny)) {
         // Simple move
         return move_cell(curr_cells, next_cells, x, y, nx, ny);
     }
@@ -95,11 +98,15 @@ bool MovementUtils::swap_or_move(
     const CellData src_cell = curr_cells.get(x, y);
     const CellData dst_cell = curr_cells.get(nx, ny);
 
-    next_cells.get(nx, ny) = src_cell;
-    next_cells.get(x, y) = dst_cell;
+    next_cells.set(nx, ny, src_cell);
+    next_cells.set(x, y, dst_cell);
 
     next_cells.mark_written(nx, ny);
     next_cells.mark_written(x, y);
+    next_cells.wake(x, y);
+    next_cells.wake(nx, ny);
+    if (MovementStats *stats = MovementStats::current)
+        stats->swaps++;
     return true;
 }
 
@@ -112,9 +119,9 @@ bool MovementUtils::try_move(
 {
     const int dest_x = x + dx * distance;
     const int dest_y = y + dy * distance;
-    if (!curr_cells.within_bounds(dest_x, dest_y)) return false;
-    if (!can_displace(curr_cells, next_cells, x, y, dest_x, dest_y)) return false;
-    return swap_or_move(curr_cells, next_cells, x, y, dest_x, dest_y);
+    const bool moved = can_displace(curr_cells, next_cells, x, y, dest_x, dest_y)
+        && swap_or_move(curr_cells, next_cells, x, y, dest_x, dest_y);
+    return count_attempt(MovementRoutine::TRY_MOVE, moved);
 }
 
 bool MovementUtils::try_lateral_wiggle(
@@ -125,17 +132,16 @@ bool MovementUtils::try_lateral_wiggle(
 {
     // Gated randomness to reduce ping-pong meshes
     if (!RandomUtils::coin_flip()) {
-        return false;
+        return count_attempt(MovementRoutine::TRY_LATERAL_WIGGLE, false);
     }
     for (int i = 0; i < 2; ++i) {
         const int nx = x + dirs[i];
         const int ny = y;
-        if (!curr_cells.within_bounds(nx, ny)) continue;
         if (can_displace(curr_cells, next_cells, x, y, nx, ny)) {
-            return swap_or_move(curr_cells, next_cells, x, y, nx, ny);
+            return count_attempt(MovementRoutine::TRY_LATERAL_WIGGLE, swap_or_move(curr_cells, next_cells, x, y, nx, ny));
         }
     }
-    return false;
+    return count_attempt(MovementRoutine::TRY_LATERAL_WIGGLE, false);
 }
 
 bool MovementUtils::is_horizontal_path_clear(
@@ -146,11 +152,7 @@ bool MovementUtils::is_horizontal_path_clear(
 {
     for (int j = 1; j <= distance; ++j) {
         const int check_x = start_x + direction * j;
-        if (!next_cells.within_bounds(check_x, y)) {
-            return false;
-        }
-        const ElementType* type = next_cells.get_type(check_x, y);
-        if (!ElementTypeChecker::is_empty(*type)) {
+        if (!next_cells.is_empty(check_x, y)) {
             return false;
         }
     }
@@ -162,10 +164,8 @@ bool MovementUtils::can_move_to(
     const int x, const int y,
     const bool allow_liquids)
 {
-    const auto pos = Vector2I(x, y);
-    if (!next_cells.within_bounds(pos)) return false;
     if (next_cells.is_written(x, y)) return false;
-    return next_cells.is_empty(pos);
+    return next_cells.is_empty(x, y);
 }
 
 bool MovementUtils::try_slide_movement(
@@ -182,8 +182,6 @@ bool MovementUtils::try_slide_movement(
             const int nx = x + dir * i;
             const int ny = y + dy;
             
-            if (!curr_cells.within_bounds(nx, ny)) continue;
-            
             // Check if the horizontal path is clear
             if (!is_horizontal_path_clear(next_cells, x, y, dir, i)) {
                 continue;
@@ -191,11 +189,11 @@ bool MovementUtils::try_slide_movement(
             
             // Density-based displacement
             if (can_displace(curr_cells, next_cells, x, y, nx, ny)) {
-                return swap_or_move(curr_cells, next_cells, x, y, nx, ny);
+                return count_attempt(MovementRoutine::TRY_SLIDE_MOVEMENT, swap_or_move(curr_cells, next_cells, x, y, nx, ny));
             }
         }
     }
-    return false;
+    return count_attempt(MovementRoutine::TRY_SLIDE_MOVEMENT, false);
 }
 
 bool MovementUtils::try_solid_diagonal_movement(
@@ -207,11 +205,10 @@ bool MovementUtils::try_solid_diagonal_movement(
     for (int i = 0; i < 2; ++i) {
         const int nx = x + dirs[i];
         const int ny = y + 1;
-        if (!curr_cells.within_bounds(nx, ny)) continue;
         if (!is_horizontal_path_clear(next_cells, x, y, dirs[i], 1)) continue;
         if (can_displace(curr_cells, next_cells, x, y, nx, ny)) {
-            return swap_or_move(curr_cells, next_cells, x, y, nx, ny);
+            return count_attempt(MovementRoutine::TRY_SOLID_DIAGONAL_MOVEMENT, swap_or_move(curr_cells, next_cells, x, y, nx, ny));
         }
     }
-    return false;
+    return count_attempt(MovementRoutine::TRY_SOLID_DIAGONAL_MOVEMENT, false);
 }
@@ -7,10 +7,19 @@
 
 #include "../elements/element_type.h"
 
+class CellMatrix;
+
+/**
+ * @brief Movement kernels shared by the particle kinds.
+ *
+ * None of these check bounds: targets may be at most CellMatrix::PADDING cells past the
+ * grid, where the wall border blocks every move.
+ */
 class MovementUtils {
 public:
     /**
      * @brief Move a cell from (src_x, src_y) to (dest_x, dest_y) in the next buffer.
+     * @details Wakes the chunks around both cells for the next tick.
      * @param curr_cells Current simulation buffer (read source from here).
      * @param next_cells Next simulation buffer (write destination here).
      * @param src_x Source X coordinate.
@@ -48,6 +57,7 @@ public:
 
     /**
      * @brief Execute either a move (into EMPTY) or a swap (with non-EMPTY) and mark write mask.
+     * @details Wakes the chunks around both cells for the next tick.
      * @param curr_cells Current simulation buffer.
      * @param next_cells Next simulation buffer (write target).
      * @param x Source X coordinate.
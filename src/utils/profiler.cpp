@@ -0,0 +1,310 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+
+// Phases first, then one track per ElementKind for the scan estimates
+static constexpr int PHASE_COUNT = static_cast<int>(ProfilePhase::COUNT);
+static constexpr int TRACK_COUNT = PHASE_COUNT + Profiler::KIND_COUNT;
+
+namespace {
+
+struct Event {
+    int16_t track;
+    int16_t thread;
+    int64_t begin_ns;
+    int64_t duration_ns;
+};
+
+struct History {
+    std::array<double, Profiler::HISTORY> ms {};
+    int count = 0;
+    int next = 0;
+
+    void push(const double value)
+    {
+        ms[next] = value;
+        next = (next + 1) % Profiler::HISTORY;
+        count = std::min(count + 1, Profiler::HISTORY);
+    }
+};
+
+struct State {
+    std::mutex mutex;
+    std::array<History, TRACK_COUNT> history;
+    std::vector<Event> events; // Ring of MAX_EVENTS once full, oldest at next_event
+    size_t next_event = 0;
+    int64_t last_scan_ns = 0; // Wall time of the latest PARTICLE_SCAN, split by end_tick()
+
+    std::array<std::atomic<int64_t>, Profiler::KIND_COUNT> cells {};
+    std::array<std::atomic<int64_t>, Profiler::KIND_COUNT> sample_ns {};
+    std::array<std::atomic<int64_t>, Profiler::KIND_COUNT> samples {};
+
+    void log(const int track, const int64_t begin_ns, const int64_t duration_ns);
+};
+
+struct CellCounts {
+    std::array<int64_t, Profiler::KIND_COUNT> cells {};
+    std::array<int64_t, Profiler::KIND_COUNT> sample_ns {};
+    std::array<int64_t, Profiler::KIND_COUNT> samples {};
+};
+
+}
+
+static State &state()
+{
+    static State instance;
+    return instance;
+}
+
+static int16_t thread_id()
+{
+    static std::atomic<int16_t> next_id { 0 };
+    thread_local const int16_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+static CellCounts &cell_counts()
+{
+    thread_local CellCounts counts;
+    return counts;
+}
+
+void State::log(const int track, const int64_t begin_ns, const int64_t duration_ns)
+{
+    history[track].push(static_cast<double>(duration_ns) / 1e6);
+    const Event event { static_cast<int16_t>(track), thread_id(), begin_ns, duration_ns };
+    if (events.size() < Profiler::MAX_EVENTS) {
+        events.push_back(event);
+    } else {
+        events[next_event] = event;
+        next_event = (next_event + 1) % Profiler::MAX_EVENTS;
+    }
+}
+
+std::atomic<bool> &Profiler::enabled_flag()
+{
+    static std::atomic<bool> enabled { false };
+    return enabled;
+}
+
+void Profiler::set_enabled(const bool enabled)
+{
+    enabled_flag().store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::reset()
+{
+    State &s = state();
+    std::lock_guard lock(s.mutex);
+    s.history = {};
+    s.events.clear();
+    s.next_event = 0;
+}
+
+int64_t Profiler::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const ProfilePhase phase, const int64_t begin_ns, const int64_t end_ns)
+{
+    State &s = state();
+    std::lock_guard lock(s.mutex);
+    s.log(static_cast<int>(phase), begin_ns, end_ns - begin_ns);
+    if (phase == ProfilePhase::PARTICLE_SCAN)
+        s.last_scan_ns = end_ns - begin_ns;
+}
+
+bool Profiler::count_cell(const ElementKind kind)
+{
+    return ++cell_counts().cells[static_cast<int>(kind)] % CELL_SAMPLE_RATE == 0;
+}
+
+void Profiler::add_cell_sample(const ElementKind kind, const int64_t ns)
+{
+    CellCounts &counts = cell_counts();
+    counts.sample_ns[static_cast<int>(kind)] += ns;
+    counts.samples[static_cast<int>(kind)]++;
+}
+
+void Profiler::add_cell_batch(const ElementKind kind, const int cells, const int64_t ns)
+{
+    CellCounts &counts = cell_counts();
+    counts.cells[static_cast<int>(kind)] += cells;
+    counts.sample_ns[static_cast<int>(kind)] += ns;
+    counts.samples[static_cast<int>(kind)] += cells;
+}
+
+void Profiler::flush_cells()
+{
+    State &s = state();
+    CellCounts &counts = cell_counts();
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (counts.cells[k] == 0)
+            continue;
+        s.cells[k].fetch_add(counts.cells[k], std::memory_order_relaxed);
+        s.sample_ns[k].fetch_add(counts.sample_ns[k], std::memory_order_relaxed);
+        s.samples[k].fetch_add(counts.samples[k], std::memory_order_relaxed);
+    }
+    counts = {};
+}
+
+void Profiler::end_tick()
+{
+    State &s = state();
+    const int64_t now = now_ns();
+    std::lock_guard lock(s.mutex);
+    std::array<double, KIND_COUNT> estimates {};
+    double total = 0.0;
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        const int64_t cells = s.cells[k].exchange(0, std::memory_order_relaxed);
+        const int64_t sample_ns = s.sample_ns[k].exchange(0, std::memory_order_relaxed);
+        const int64_t samples = s.samples[k].exchange(0, std::memory_order_relaxed);
+        // A kind seen fewer than CELL_SAMPLE_RATE times in a tick has no timed cell yet
+        estimates[k] = samples > 0 ? static_cast<double>(sample_ns) * cells / samples : 0.0;
+        total += estimates[k];
+    }
+    if (total <= 0.0)
+        return;
+    // Samples include the clock reads and sum CPU time over all workers, so they only give
+    // each kind's share of the scan's wall time
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (estimates[k] > 0.0)
+            s.log(PHASE_COUNT + k, now, static_cast<int64_t>(estimates[k] / total * s.last_scan_ns));
+    }
+}
+
+static Profiler::Stats make_stats(const History &history)
+{
+    Profiler::Stats stats;
+    stats.samples = history.count;
+    if (history.count == 0)
+        return stats;
+    std::vector<double> sorted(history.ms.begin(), history.ms.begin() + history.count);
+    std::ranges::sort(sorted);
+    double sum = 0.0;
+    for (const double ms : sorted) {
+        sum += ms;
+    }
+    stats.last_ms = history.ms[(history.next + Profiler::HISTORY - 1) % Profiler::HISTORY];
+    stats.mean_ms = sum / history.count;
+    stats.p50_ms = sorted[sorted.size() / 2];
+    stats.p99_ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    stats.max_ms = sorted.back();
+    return stats;
+}
+
+Profiler::Stats Profiler::get_stats(const ProfilePhase phase)
+{
+    State &s = state();
+    std::lock_guard lock(s.mutex);
+    return make_stats(s.history[static_cast<int>(phase)]);
+}
+
+Profiler::Stats Profiler::get_kind_stats(const ElementKind kind)
+{
+    State &s = state();
+    std::lock_guard lock(s.mutex);
+    return make_stats(s.history[PHASE_COUNT + static_cast<int>(kind)]);
+}
+
+const char* Profiler::get_phase_name(const ProfilePhase phase)
+{
+    switch (phase) {
+        case ProfilePhase::INPUT: return "input";
+        case ProfilePhase::TICK: return "tick";
+        case ProfilePhase::BUFFER_COPY: return "buffer_copy";
+        case ProfilePhase::PARTICLE_SCAN: return "particle_scan";
+        case ProfilePhase::HEAT: return "heat";
+        case ProfilePhase::RENDER_FILL: return "render_fill";
+        case ProfilePhase::TEXTURE_UPLOAD: return "texture_upload";
+        default: return "unknown";
+    }
+}
+
+const char* Profiler::get_kind_name(const ElementKind kind)
+{
+    switch (kind) {
+        case ElementKind::Empty: return "Empty";
+        case ElementKind::Liquid: return "Liquid";
+        case ElementKind::MovableSolid: return "MovableSolid";
+        case ElementKind::ImmovableSolid: return "ImmovableSolid";
+        case ElementKind::Gas: return "Gas";
+        default: return "Unknown";
+    }
+}
+
+static const char* track_name(const int track)
+{
+    if (track < PHASE_COUNT)
+        return Profiler::get_phase_name(static_cast<ProfilePhase>(track));
+    return Profiler::get_kind_name(static_cast<ElementKind>(track - PHASE_COUNT));
+}
+
+// Logged events oldest first, copied so the files are written without holding the lock.
+// `origin_ns` is the earliest begin time, which the exports count from.
+static std::vector<Event> copy_events(int64_t &origin_ns)
+{
+    State &s = state();
+    std::lock_guard lock(s.mutex);
+    std::vector<Event> events(s.events.begin() + s.next_event, s.events.end());
+    events.insert(events.end(), s.events.begin(), s.events.begin() + s.next_event);
+    origin_ns = events.empty() ? 0 : events.front().begin_ns;
+    for (const Event &event : events) {
+        origin_ns = std::min(origin_ns, event.begin_ns);
+    }
+    return events;
+}
+
+bool Profiler::write_chrome_trace(const std::string &path)
+{
+    int64_t origin_ns = 0;
+    const std::vector<Event> events = copy_events(origin_ns);
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const Event &event : events) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        const double ts_us = static_cast<double>(event.begin_ns - origin_ns) / 1e3;
+        const double duration_us = static_cast<double>(event.duration_ns) / 1e3;
+        if (event.track < PHASE_COUNT) {
+            out << "{\"name\":\"" << track_name(event.track) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << event.thread << ",\"ts\":" << ts_us << ",\"dur\":" << duration_us << "}";
+        } else {
+            // Estimates are not intervals, so they go on a counter track in milliseconds
+            out << "{\"name\":\"scan_by_kind\",\"ph\":\"C\",\"pid\":1,\"ts\":" << ts_us
+                << ",\"args\":{\"" << track_name(event.track) << "\":" << duration_us / 1e3 << "}}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+bool Profiler::write_csv(const std::string &path)
+{
+    int64_t origin_ns = 0;
+    const std::vector<Event> events = copy_events(origin_ns);
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+
+    out << "kind,name,thread,begin_us,duration_us\n";
+    for (const Event &event : events) {
+        out << (event.track < PHASE_COUNT ? "phase," : "scan_kind,") << track_name(event.track) << ','
+            << event.thread << ',' << static_cast<double>(event.begin_ns - origin_ns) / 1e3 << ','
+            << static_cast<double>(event.duration_ns) / 1e3 << '\n';
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,114 @@
+//
+// Created by João Dowsley on 17/10/26.
+//
+
+#ifndef SANDSTONE_PROFILER_H
+#define SANDSTONE_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../elements/element_type.h"
+
+enum class ProfilePhase {
+    INPUT = 0,
+    TICK,
+    BUFFER_COPY,
+    PARTICLE_SCAN,
+    HEAT,
+    RENDER_FILL,
+    TEXTURE_UPLOAD,
+    COUNT
+};
+
+/**
+ * @brief Process-wide timings of the frame and tick phases.
+ *
+ * Each phase keeps its last HISTORY durations for the rolling statistics, and every sample is
+ * also logged (up to MAX_EVENTS, oldest dropped) for export as a Chrome trace or CSV. The
+ * particle scan is further split per ElementKind: the scan counts cells per kind and times one
+ * cell in CELL_SAMPLE_RATE, and the scan's wall time is divided in proportion to each kind's
+ * mean sampled cost times its count.
+ *
+ * Disabled by default. When disabled, a scope costs one relaxed load; builds configured with
+ * SANDSTONE_PROFILING off fold it away entirely.
+ */
+class Profiler {
+public:
+    static constexpr int HISTORY = 240;
+    static constexpr size_t MAX_EVENTS = size_t { 1 } << 18;
+    static constexpr int KIND_COUNT = static_cast<int>(ElementKind::Gas) + 1;
+    static constexpr int CELL_SAMPLE_RATE = 32;
+
+    struct Stats {
+        double last_ms = 0.0;
+        double mean_ms = 0.0;
+        double p50_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+        int samples = 0;
+    };
+
+    static void set_enabled(bool enabled);
+    static bool is_enabled()
+    {
+#ifdef SANDSTONE_PROFILING
+        return enabled_flag().load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+    // Drops all history and logged events
+    static void reset();
+
+    static int64_t now_ns();
+    static void record(ProfilePhase phase, int64_t begin_ns, int64_t end_ns);
+
+    // Per-kind scan accounting; counts stay thread-local until flush_cells()
+    static bool count_cell(ElementKind kind);
+    static void add_cell_sample(ElementKind kind, int64_t ns);
+    // `cells` cells stepped together in `ns`, counted and timed as one sample of that many
+    static void add_cell_batch(ElementKind kind, int cells, int64_t ns);
+    static void flush_cells();
+    // Turns the kinds' counts into this tick's estimates; called once per tick
+    static void end_tick();
+
+    static Stats get_stats(ProfilePhase phase);
+    static Stats get_kind_stats(ElementKind kind);
+    static const char* get_phase_name(ProfilePhase phase);
+    static const char* get_kind_name(ElementKind kind);
+
+    // Complete ("X") events per phase, plus a counter track with the per-kind scan estimates
+    static bool write_chrome_trace(const std::string &path);
+    // One row per logged event: kind,name,thread,begin_us,duration_us
+    static bool write_csv(const std::string &path);
+
+private:
+    static std::atomic<bool> &enabled_flag();
+};
+
+/**
+ * @brief Records the time between construction and destruction as one sample of `phase`.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(const ProfilePhase phase)
+        : _phase(phase), _begin_ns(Profiler::is_enabled() ? Profiler::now_ns() : -1) {}
+    ~ProfileScope()
+    {
+        if (_begin_ns >= 0)
+            Profiler::record(_phase, _begin_ns, Profiler::now_ns());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfilePhase _phase;
+    int64_t _begin_ns;
+};
+
+#endif //SANDSTONE_PROFILER_H
@@ -4,8 +4,45 @@
 
 #include "random_utils.h"
 
+#include <algorithm>
 #include <chrono>
-#include <limits>
+
+static uint64_t rotl(const uint64_t x, const int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void RandomUtils::Engine::seed(uint64_t seed)
+{
+    // splitmix64 expands the seed so that no state word is left at zero
+    for (uint64_t &word : s) {
+        word = splitmix64(seed);
+    }
+    flip_bits = 0;
+    flips_left = 0;
+}
+
+uint64_t RandomUtils::Engine::next()
+{
+    // xoshiro256**
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
 
 // Global seed state used to seed thread-local engines.
 std::atomic<uint64_t> &RandomUtils::global_seed_state()
@@ -28,9 +65,13 @@ uint64_t RandomUtils::next_seed()
     return x * 2685821657736338717ull;
 }
 
-std::mt19937 &RandomUtils::engine()
+RandomUtils::Engine &RandomUtils::engine()
 {
-    thread_local std::mt19937 eng(static_cast<uint32_t>(next_seed()));
+    thread_local Engine eng = [] {
+        Engine e {};
+        e.seed(next_seed());
+        return e;
+    }();
     return eng;
 }
 
@@ -43,19 +84,62 @@ void RandomUtils::reseed(const uint32_t seed)
 
 int RandomUtils::uniform_int(const int min_inclusive, const int max_inclusive)
 {
-    std::uniform_int_distribution dist(min_inclusive, max_inclusive);
-    return dist(engine());
+    // Lemire's multiply-shift with its rejection step, so every value is exactly equally likely.
+    // A draw is only rejected when its low product bits fall below 2^32 mod span, which for
+    // the small spans the simulation uses almost never happens.
+    const uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(max_inclusive) - min_inclusive) + 1;
+    uint64_t r = engine().next() >> 32;
+    if (span > UINT32_MAX) // The full int range: every 32-bit draw maps to one value
+        return static_cast<int>(min_inclusive + static_cast<int64_t>(r));
+    uint64_t product = r * span;
+    if (static_cast<uint32_t>(product) < span) {
+        const uint32_t threshold = static_cast<uint32_t>(-span) % static_cast<uint32_t>(span);
+        while (static_cast<uint32_t>(product) < threshold) {
+            r = engine().next() >> 32;
+            product = r * span;
+        }
+    }
+    return static_cast<int>(min_inclusive + static_cast<int64_t>(product >> 32));
 }
 
 float RandomUtils::uniform_float(const float min_inclusive, const float max_exclusive)
 {
-    std::uniform_real_distribution<float> dist(min_inclusive, std::nextafter(max_exclusive, std::numeric_limits<float>::max()));
-    return dist(engine());
+    // Top 24 bits give every float in [0, 1) with equal spacing
+    const float unit = static_cast<float>(engine().next() >> 40) * 0x1.0p-24f;
+    return min_inclusive + (max_exclusive - min_inclusive) * unit;
 }
 
 bool RandomUtils::coin_flip()
 {
-    return uniform_int(0, 1) == 1;
+    Engine &eng = engine();
+    if (eng.flips_left == 0) {
+        eng.flip_bits = eng.next();
+        eng.flips_left = 64;
+    }
+    const bool flip = eng.flip_bits & 1;
+    eng.flip_bits >>= 1;
+    eng.flips_left--;
+    return flip;
+}
+
+uint64_t RandomUtils::coin_flips(const int count)
+{
+    Engine &eng = engine();
+    uint64_t flips = 0;
+    int taken = 0;
+    while (taken < count) {
+        if (eng.flips_left == 0) {
+            eng.flip_bits = eng.next();
+            eng.flips_left = 64;
+        }
+        const int n = std::min(count - taken, eng.flips_left);
+        const uint64_t mask = n == 64 ? ~uint64_t { 0 } : (uint64_t { 1 } << n) - 1;
+        flips |= (eng.flip_bits & mask) << taken;
+        eng.flip_bits = n == 64 ? 0 : eng.flip_bits >> n;
+        eng.flips_left -= n;
+        taken += n;
+    }
+    return flips;
 }
 
 int RandomUtils::index(const int size)
@@ -64,4 +148,7 @@ int RandomUtils::index(const int size)
     return uniform_int(0, size - 1);
 }
 
-
+uint64_t RandomUtils::bits()
+{
+    return engine().next();
+}
@@ -5,20 +5,31 @@
 #ifndef SANDSTONE_RANDOM_UTILS_H
 #define SANDSTONE_RANDOM_UTILS_H
 
-#include <random>
 #include <atomic>
+#include <cstdint>
 
 /**
  * @brief Thread-safe randomness machine. 
  * 
+ * Each thread owns a xoshiro256** generator (32 bytes of state). coin_flip() draws from a
+ * cached 64-bit word one bit at a time, so most flips do not touch the generator at all.
  */
 class RandomUtils {
 private:
+    struct Engine {
+        uint64_t s[4];
+        uint64_t flip_bits = 0;
+        int flips_left = 0;
+
+        void seed(uint64_t seed);
+        uint64_t next();
+    };
+
     // Global seed state used to initialize per-thread RNGs
     static std::atomic<uint64_t> &global_seed_state();
     static uint64_t next_seed();
     // Per-thread engine (thread-safe, no sharing across threads)
-    static std::mt19937 &engine();
+    static Engine &engine();
 
 public:
     // Reseed with a fixed value (useful for tests/determinism)
@@ -33,8 +44,15 @@ public:
     // 50/50 coin flip
     static bool coin_flip();
 
+    // The next `count` (at most 64) coin flips, bit i holding the i-th; the same stream as
+    // calling coin_flip() `count` times
+    static uint64_t coin_flips(int count);
+
     // Pick a random index in [0, size)
     static int index(int size);
+
+    // Raw 64 random bits, e.g. 64 coin flips to consume in bulk
+    static uint64_t bits();
 };
 
 #endif // SANDSTONE_RANDOM_UTILS_H